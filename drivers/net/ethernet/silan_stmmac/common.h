@@ -86,11 +86,15 @@ struct stmmac_extra_stats {
 	unsigned long fatal_bus_error_irq;
 	/* Extra info */
 	unsigned long threshold;
-	unsigned long tx_pkt_n;
-	unsigned long rx_pkt_n;
-	unsigned long poll_n;
 	unsigned long sched_timer_n;
 	unsigned long normal_irq_n;
+	/* RX cache maintenance */
+	unsigned long rx_sync_saved_bps;
+	/* Dynamic interrupt moderation */
+	unsigned long rx_dim_profile;
+	unsigned long rx_dim_transitions;
+	unsigned long tx_dim_profile;
+	unsigned long tx_dim_transitions;
 };
 
 #define HASH_TABLE_SIZE 64
@@ -111,14 +115,12 @@ enum rx_frame_status { /* IPC status */
 	llc_snap = 4,
 };
 
+/* DMA interrupt status: a bitmask, each direction is handled on its own */
 enum tx_dma_irq_status {
-	tx_hard_error = 1,
-	tx_hard_error_bump_tc = 2,
-	handle_tx_rx = 3,
-#ifdef CONFIG_SILAN_GMAC_TX_POSTCHK
-    handle_tx = 4,
-	handle_rx = 8,
-#endif	
+	tx_hard_error = 0x1,
+	tx_hard_error_bump_tc = 0x2,
+	handle_rx = 0x10,
+	handle_tx = 0x20,
 };
 
 /* GMAC TX FIFO is 8K, Rx FIFO is 16K */
@@ -126,6 +128,7 @@ enum tx_dma_irq_status {
 #define BUF_SIZE_8KiB 8192
 #define BUF_SIZE_4KiB 4096
 #define BUF_SIZE_2KiB 2048
+#define BUF_SIZE_1_5KiB 1536
 
 /* Power Down and WOL */
 #define PMT_NOT_SUPPORTED 0
@@ -150,7 +153,7 @@ enum tx_dma_irq_status {
 struct stmmac_desc_ops {
 	/* DMA RX descriptor ring initialization */
 	void (*init_rx_desc) (struct dma_desc *p, unsigned int ring_size,
-			      int disable_rx_ic);
+			      int disable_rx_ic, int bfsize);
 	/* DMA TX descriptor ring initialization */
 	void (*init_tx_desc) (struct dma_desc *p, unsigned int ring_size);
 
@@ -167,6 +170,8 @@ struct stmmac_desc_ops {
 	/* Clear interrupt on tx frame completion. When this bit is
 	 * set an interrupt happens as soon as the frame is transmitted */
 	void (*clear_tx_ic) (struct dma_desc *p);
+	/* Enable/disable the interrupt on completion of a rx descriptor */
+	void (*set_rx_ic) (struct dma_desc *p, int ic);
 	/* Last tx segment reports the transmit status */
 	int (*get_tx_ls) (struct dma_desc *p);
 	/* Return the transmit status looking at the TDES1 */
@@ -179,6 +184,9 @@ struct stmmac_desc_ops {
 	void (*set_rx_owner) (struct dma_desc *p);
 	/* Get the receive frame size */
 	int (*get_rx_frame_len) (struct dma_desc *p);
+	/* First/last descriptor of a frame spanning several buffers */
+	int (*get_rx_fs) (struct dma_desc *p);
+	int (*get_rx_ls) (struct dma_desc *p);
 	/* Return the reception status looking at the RDES1 */
 	int (*rx_status) (void *data, struct stmmac_extra_stats *x,
 			  struct dma_desc *p);
@@ -196,14 +204,19 @@ struct stmmac_dma_ops {
 	void (*dma_diagnostic_fr) (void *data, struct stmmac_extra_stats *x,
 				   void __iomem *ioaddr);
 	void (*enable_dma_transmission) (void __iomem *ioaddr);
-	void (*enable_dma_irq) (void __iomem *ioaddr);
-	void (*disable_dma_irq) (void __iomem *ioaddr);
+	/* Unmask/mask the RX and/or TX completion interrupts */
+	void (*enable_dma_irq) (void __iomem *ioaddr, bool rx, bool tx);
+	void (*disable_dma_irq) (void __iomem *ioaddr, bool rx, bool tx);
 	void (*start_tx) (void __iomem *ioaddr);
 	void (*stop_tx) (void __iomem *ioaddr);
 	void (*start_rx) (void __iomem *ioaddr);
 	void (*stop_rx) (void __iomem *ioaddr);
+	/* Move the stopped DMA onto new descriptor lists */
+	void (*set_rings) (void __iomem *ioaddr, u32 dma_tx, u32 dma_rx);
 	int (*dma_interrupt) (void __iomem *ioaddr,
 			      struct stmmac_extra_stats *x);
+	/* Program the RX interrupt watchdog timer (if supported) */
+	void (*rx_watchdog) (void __iomem *ioaddr, u32 riwt);
 };
 
 struct stmmac_ops {
@@ -223,7 +236,7 @@ struct stmmac_ops {
 	/* Set power management mode (e.g. magic frame) */
 	void (*pmt) (void __iomem *ioaddr, unsigned long mode);
 	/* Set/Get Unicast MAC addresses */
-	void (*set_umac_addr) (void __iomem *ioaddr, unsigned char *addr,
+	void (*set_umac_addr) (void __iomem *ioaddr, const unsigned char *addr,
 			       unsigned int reg_n);
 	void (*get_umac_addr) (void __iomem *ioaddr, unsigned char *addr,
 			       unsigned int reg_n);
@@ -251,7 +264,7 @@ struct mac_device_info {
 struct mac_device_info *dwmac1000_setup(void __iomem *ioaddr);
 struct mac_device_info *dwmac100_setup(void __iomem *ioaddr);
 
-extern void stmmac_set_mac_addr(void __iomem *ioaddr, u8 addr[6],
+extern void stmmac_set_mac_addr(void __iomem *ioaddr, const u8 addr[6],
 				unsigned int high, unsigned int low);
 extern void stmmac_get_mac_addr(void __iomem *ioaddr, unsigned char *addr,
 				unsigned int high, unsigned int low);
@@ -320,4 +320,37 @@ enum desc01_etx_mask_e {
 	*((volatile u32 *)(desc) + 1 ) |= ((value) << (offset)); \
 	}
 
+/* Status words as a whole, for the RX/TX poll loops that load RDES0/TDES0
+ * once and test it with masks instead of going through the bitfields. */
+#define RDES0_OWN		(1U << 31)
+#define RDES0_FRAME_LEN_SHIFT	16
+#define RDES0_FRAME_LEN_MASK	0x3fff
+#define RDES0_ES		(1U << 15)
+#define RDES0_FS		(1U << 9)
+#define RDES0_LS		(1U << 8)
+#define RDES0_DRIBBLING		(1U << 2)
+#define RDES0_LENGTH_ERROR	(1U << 12)
+/* normal descriptor */
+#define RDES0_N_MII_ERROR	(1U << 3)
+#define RDES0_N_MULTICAST	(1U << 10)
+/* enhanced descriptor */
+#define RDES0_E_PAYLOAD_CSUM	(1U << 0)
+#define RDES0_E_FRAME_TYPE	(1U << 5)
+#define RDES0_E_IPC_CSUM	(1U << 7)
+#define RDES0_E_VLAN_TAG	(1U << 10)
+#define RDES0_E_SA_FAIL		(1U << 13)
+#define RDES0_E_DA_FAIL		(1U << 30)
+
+#define TDES0_OWN		(1U << 31)
+#define TDES0_ES		(1U << 15)
+#define TDES0_DEFERRED		(1U << 0)
+/* normal descriptor: the last segment bit is in TDES1 */
+#define TDES0_N_HEARTBEAT_FAIL	(1U << 7)
+#define TDES1_N_END_RING	(1U << 25)
+#define TDES1_N_LS		(1U << 30)
+/* enhanced descriptor */
+#define TDES0_E_VLAN_FRAME	(1U << 7)
+#define TDES0_E_END_RING	(1U << 21)
+#define TDES0_E_LS		(1U << 29)
+
 #endif /* STMMAC_DESCS_H */
@@ -148,9 +148,6 @@ enum rx_tx_priority_ratio {
 #define DMA_BUS_MODE_4PBL	0x01000000
 #define DMA_BUS_MODE_AAL	0x02000000
 
-/* DMA CRS Control and Status Register Mapping */
-#define DMA_HOST_TX_DESC	  0x00001048	/* Current Host Tx descriptor */
-#define DMA_HOST_RX_DESC	  0x0000104c	/* Current Host Rx descriptor */
 /*  DMA Bus Mode register defines */
 #define DMA_BUS_PR_RATIO_MASK	  0x0000c000	/* Rx/Tx priority ratio */
 #define DMA_BUS_PR_RATIO_SHIFT	  14
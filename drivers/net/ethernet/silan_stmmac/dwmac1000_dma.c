@@ -117,11 +117,12 @@ static void dwmac1000_dma_operation_mode(void __iomem *ioaddr, int txmode,
 	writel(csr6, ioaddr + DMA_CONTROL);
 }
 
-/* Not yet implemented --- no RMON module */
-static void dwmac1000_dma_diagnostic_fr(void *data,
-		  struct stmmac_extra_stats *x, void __iomem *ioaddr)
+/* The RX watchdog counts in units of 256 system clock cycles; as soon as
+ * it expires the RI bit is raised for the frames received meanwhile from
+ * descriptors that have the interrupt on completion disabled. */
+static void dwmac1000_rx_watchdog(void __iomem *ioaddr, u32 riwt)
 {
-	return;
+	writel(riwt, ioaddr + DMA_RX_WATCHDOG);
 }
 
 static void dwmac1000_dump_dma_regs(void __iomem *ioaddr)
@@ -142,7 +143,7 @@ const struct stmmac_dma_ops dwmac1000_dma_ops = {
 	.init = dwmac1000_dma_init,
 	.dump_regs = dwmac1000_dump_dma_regs,
 	.dma_mode = dwmac1000_dma_operation_mode,
-	.dma_diagnostic_fr = dwmac1000_dma_diagnostic_fr,
+	.dma_diagnostic_fr = dwmac_dma_diagnostic_fr,
 	.enable_dma_transmission = dwmac_enable_dma_transmission,
 	.enable_dma_irq = dwmac_enable_dma_irq,
 	.disable_dma_irq = dwmac_disable_dma_irq,
@@ -150,5 +151,7 @@ const struct stmmac_dma_ops dwmac1000_dma_ops = {
 	.stop_tx = dwmac_dma_stop_tx,
 	.start_rx = dwmac_dma_start_rx,
 	.stop_rx = dwmac_dma_stop_rx,
+	.set_rings = dwmac_dma_set_rings,
 	.dma_interrupt = dwmac_dma_interrupt,
+	.rx_watchdog = dwmac1000_rx_watchdog,
 };
@@ -87,7 +87,8 @@ static void dwmac100_irq_status(void __iomem *ioaddr)
 	return;
 }
 
-static void dwmac100_set_umac_addr(void __iomem *ioaddr, unsigned char *addr,
+static void dwmac100_set_umac_addr(void __iomem *ioaddr,
+				   const unsigned char *addr,
 				   unsigned int reg_n)
 {
 	stmmac_set_mac_addr(ioaddr, addr, MAC_ADDR_HIGH, MAC_ADDR_LOW);
@@ -21,8 +21,10 @@
 *******************************************************************************/
 
 #include <linux/io.h>
+#include <linux/delay.h>
 #include "common.h"
 #include "dwmac_dma.h"
+#include "stmmac_trace.h"
 
 #undef DWMAC_DMA_DEBUG
 #ifdef DWMAC_DMA_DEBUG
@@ -37,14 +39,28 @@ void dwmac_enable_dma_transmission(void __iomem *ioaddr)
 	writel(1, ioaddr + DMA_XMT_POLL_DEMAND);
 }
 
-void dwmac_enable_dma_irq(void __iomem *ioaddr)
+/* The abnormal interrupts stay enabled; the caller serializes the
+ * read-modify-write of CSR7 between the two directions. */
+void dwmac_enable_dma_irq(void __iomem *ioaddr, bool rx, bool tx)
 {
-	writel(DMA_INTR_DEFAULT_MASK, ioaddr + DMA_INTR_ENA);
+	u32 value = readl(ioaddr + DMA_INTR_ENA);
+
+	if (rx)
+		value |= DMA_INTR_RX;
+	if (tx)
+		value |= DMA_INTR_TX;
+	writel(value, ioaddr + DMA_INTR_ENA);
 }
 
-void dwmac_disable_dma_irq(void __iomem *ioaddr)
+void dwmac_disable_dma_irq(void __iomem *ioaddr, bool rx, bool tx)
 {
-	writel(0, ioaddr + DMA_INTR_ENA);
+	u32 value = readl(ioaddr + DMA_INTR_ENA);
+
+	if (rx)
+		value &= ~DMA_INTR_RX;
+	if (tx)
+		value &= ~DMA_INTR_TX;
+	writel(value, ioaddr + DMA_INTR_ENA);
 }
 
 void dwmac_dma_start_tx(void __iomem *ioaddr)
@@ -75,6 +91,55 @@ void dwmac_dma_stop_rx(void __iomem *ioaddr)
 	writel(value, ioaddr + DMA_CONTROL);
 }
 
+/* The list base addresses can only be written while both processes are
+ * stopped: the ones in progress complete the current frame first. */
+void dwmac_dma_set_rings(void __iomem *ioaddr, u32 dma_tx, u32 dma_rx)
+{
+	int limit = 1000;
+
+	while (readl(ioaddr + DMA_STATUS) &
+	       (DMA_STATUS_TS_MASK | DMA_STATUS_RS_MASK)) {
+		if (!--limit) {
+			pr_warn("%s: DMA not stopped\n", __func__);
+			break;
+		}
+		udelay(10);
+	}
+	writel(dma_tx, ioaddr + DMA_TX_BASE_ADDR);
+	writel(dma_rx, ioaddr + DMA_RCV_BASE_ADDR);
+}
+
+/* DMA controller has two counters to track the number of
+ * the receive missed frames: the ones missed for lack of descriptors and
+ * the ones lost in a FIFO overflow. The register is cleared on read. */
+void dwmac_dma_diagnostic_fr(void *data, struct stmmac_extra_stats *x,
+			     void __iomem *ioaddr)
+{
+	struct net_device_stats *stats = (struct net_device_stats *)data;
+	u32 csr8 = readl(ioaddr + DMA_MISSED_FRAME_CTR);
+
+	if (unlikely(csr8)) {
+		if (csr8 & DMA_MISSED_FRAME_OVE) {
+			stats->rx_over_errors += 0x800;
+			x->rx_overflow_cntr += 0x800;
+		} else {
+			unsigned int ove_cntr;
+			ove_cntr = ((csr8 & DMA_MISSED_FRAME_OVE_CNTR) >> 17);
+			stats->rx_over_errors += ove_cntr;
+			x->rx_overflow_cntr += ove_cntr;
+		}
+
+		if (csr8 & DMA_MISSED_FRAME_OVE_M) {
+			stats->rx_missed_errors += 0xffff;
+			x->rx_missed_cntr += 0xffff;
+		} else {
+			unsigned int miss_f = (csr8 & DMA_MISSED_FRAME_M_CNTR);
+			stats->rx_missed_errors += miss_f;
+			x->rx_missed_cntr += miss_f;
+		}
+	}
+}
+
 #ifdef DWMAC_DMA_DEBUG
 static void show_tx_process_state(unsigned int status)
 {
@@ -151,7 +216,13 @@ int dwmac_dma_interrupt(void __iomem *ioaddr,
 	int ret = 0;
 	/* read the status register (CSR5) */
 	u32 intr_status = readl(ioaddr + DMA_STATUS);
+	u32 intr_en = readl(ioaddr + DMA_INTR_ENA);
 
+	trace_stmmac_dma_irq(ioaddr, intr_status, intr_en);
+	/* All masked while the rings are rebuilt (see stmmac_quiesce): the
+	 * status is left to the restart, which clears it */
+	if (unlikely(!intr_en))
+		return 0;
 	DWMAC_LIB_DBG(KERN_INFO "%s: [CSR5: 0x%08x]\n", __func__, intr_status);
 #ifdef DWMAC_DMA_DEBUG
 	/* It displays the DMA process states (CSR5 register) */
@@ -163,7 +234,7 @@ int dwmac_dma_interrupt(void __iomem *ioaddr,
 		DWMAC_LIB_DBG(KERN_INFO "CSR5[15] DMA ABNORMAL IRQ: ");
 		if (unlikely(intr_status & DMA_STATUS_UNF)) {
 			DWMAC_LIB_DBG(KERN_INFO "transmit underflow\n");
-			ret = tx_hard_error_bump_tc;
+			ret |= tx_hard_error_bump_tc;
 			x->tx_undeflow_irq++;
 		}
 		if (unlikely(intr_status & DMA_STATUS_TJT)) {
@@ -193,34 +264,40 @@ int dwmac_dma_interrupt(void __iomem *ioaddr,
 		if (unlikely(intr_status & DMA_STATUS_TPS)) {
 			DWMAC_LIB_DBG(KERN_INFO "transmit process stopped\n");
 			x->tx_process_stopped_irq++;
-			ret = tx_hard_error;
+			ret |= tx_hard_error;
 		}
 		if (unlikely(intr_status & DMA_STATUS_FBI)) {
 			DWMAC_LIB_DBG(KERN_INFO "fatal bus error\n");
 			x->fatal_bus_error_irq++;
-			ret = tx_hard_error;
+			ret |= tx_hard_error;
 		}
 	}
 	/* TX/RX NORMAL interrupts */
 	if (intr_status & DMA_STATUS_NIS) {
 		x->normal_irq_n++;
-#ifdef CONFIG_SILAN_GMAC_TX_POSTCHK
-        if (likely((intr_status & DMA_STATUS_RI)))
-				ret = handle_rx;
-#else
-        if (likely((intr_status & (DMA_STATUS_RI | DMA_STATUS_TI))))
-				ret = handle_tx_rx;
-#endif
-    }
+		if (likely((intr_status & DMA_STATUS_RI) &&
+			   (intr_en & DMA_INTR_ENA_RIE)))
+			ret |= handle_rx;
+		if (likely((intr_status & DMA_STATUS_TI) &&
+			   (intr_en & DMA_INTR_ENA_TIE)))
+			ret |= handle_tx;
+	}
+	/* A direction whose NAPI is running has its interrupt masked: leave
+	 * its status pending, so it raises the interrupt again as soon as the
+	 * NAPI completes and unmasks it. */
+	if (!(intr_en & DMA_INTR_ENA_RIE))
+		intr_status &= ~DMA_STATUS_RI;
+	if (!(intr_en & DMA_INTR_ENA_TIE))
+		intr_status &= ~DMA_STATUS_TI;
 	/* Optional hardware blocks, interrupts should be disabled */
 	if (unlikely(intr_status &
 		     (DMA_STATUS_GPI | DMA_STATUS_GMI | DMA_STATUS_GLI)))
 		pr_info("%s: unexpected status %08x\n", __func__, intr_status);
 	/* Clear the interrupt by writing a logic 1 to the CSR5[15-0] */
-    /* Note for enhancement TX_POSTCHK:
-     * As Tx completion processing checks "cur_tx" and "dirty_tx" to determine
-     * if there is some work to be done. So the "Transmit Interrupt" bit 
-     * can be cleared there */
+    /* Note for enhancement TX_POSTCHK (and Tx timer):
+     * The "Transmit Interrupt" is kept disabled, so its status bit just
+     * stays pending: the Tx completion processing checks "cur_tx" and
+     * "dirty_tx" to determine if there is some work to be done. */
 	writel((intr_status & 0x1ffff), ioaddr + DMA_STATUS);
 
 	DWMAC_LIB_DBG(KERN_INFO "\n\n");
@@ -235,7 +312,7 @@ void dwmac_dma_flush_tx_fifo(void __iomem *ioaddr)
 	do {} while ((readl(ioaddr + DMA_CONTROL) & DMA_CONTROL_FTF));
 }
 
-void stmmac_set_mac_addr(void __iomem *ioaddr, u8 addr[6],
+void stmmac_set_mac_addr(void __iomem *ioaddr, const u8 addr[6],
 			 unsigned int high, unsigned int low)
 {
 	unsigned long data;
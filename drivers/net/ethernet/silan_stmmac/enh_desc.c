@@ -227,15 +227,21 @@ static int enh_desc_get_rx_status(void *data, struct stmmac_extra_stats *x,
 }
 
 static void enh_desc_init_rx_desc(struct dma_desc *p, unsigned int ring_size,
-				  int disable_rx_ic)
+				  int disable_rx_ic, int bfsize)
 {
 	int i;
+	/* Never let the DMA write past the buffer really provided */
+	int bf1_size = min(bfsize, BUF_SIZE_8KiB - 1);
+	int bf2_size = 0;
+
+	/* To support jumbo frames */
+	if (bfsize > BUF_SIZE_8KiB)
+		bf2_size = min(bfsize - BUF_SIZE_8KiB, BUF_SIZE_8KiB - 1);
 #ifdef GMAC_USE_BITFIELD
 	for (i = 0; i < ring_size; i++) {
 		p->des01.erx.own = 1;
-		p->des01.erx.buffer1_size = BUF_SIZE_8KiB - 1;
-		/* To support jumbo frames */
-		p->des01.erx.buffer2_size = BUF_SIZE_8KiB - 1;
+		p->des01.erx.buffer1_size = bf1_size;
+		p->des01.erx.buffer2_size = bf2_size;
 		if (i == ring_size - 1)
 			p->des01.erx.end_ring = 1;
 		if (disable_rx_ic)
@@ -245,9 +251,8 @@ static void enh_desc_init_rx_desc(struct dma_desc *p, unsigned int ring_size,
 #else
 	for (i = 0; i < ring_size; i++) {
 		GMAC_DESC0_SET(p, DESC0_ERX_OWN);
-		GMAC_DESC1_WRITE(p, DESC1_ERX_BUFFER1_SIZE, DESC1_ERX_MASK_BUFFER1_SIZE, BUF_SIZE_8KiB - 1);
-		/* To support jumbo frames */
-		GMAC_DESC1_WRITE(p, DESC1_ERX_BUFFER2_SIZE, DESC1_ERX_MASK_BUFFER2_SIZE, BUF_SIZE_8KiB - 1);
+		GMAC_DESC1_WRITE(p, DESC1_ERX_BUFFER1_SIZE, DESC1_ERX_MASK_BUFFER1_SIZE, bf1_size);
+		GMAC_DESC1_WRITE(p, DESC1_ERX_BUFFER2_SIZE, DESC1_ERX_MASK_BUFFER2_SIZE, bf2_size);
 		if (i == ring_size - 1)
 			GMAC_DESC1_SET(p, DESC1_ERX_END_RING);
 		if (disable_rx_ic)
@@ -361,6 +366,18 @@ static void enh_desc_clear_tx_ic(struct dma_desc *p)
 #endif
 }
 
+static void enh_desc_set_rx_ic(struct dma_desc *p, int ic)
+{
+#ifdef GMAC_USE_BITFIELD
+	p->des01.erx.disable_ic = !ic;
+#else
+	if (ic)
+		GMAC_DESC1_CLR(p, DESC1_ERX_DISABLE_IC);
+	else
+		GMAC_DESC1_SET(p, DESC1_ERX_DISABLE_IC);
+#endif
+}
+
 static void enh_desc_close_tx_desc(struct dma_desc *p)
 {
 #ifdef GMAC_USE_BITFIELD
@@ -377,6 +394,16 @@ static int enh_desc_get_rx_frame_len(struct dma_desc *p)
 	return p->des01.erx.frame_length;
 }
 
+static int enh_desc_get_rx_fs(struct dma_desc *p)
+{
+	return p->des01.erx.first_descriptor;
+}
+
+static int enh_desc_get_rx_ls(struct dma_desc *p)
+{
+	return p->des01.erx.last_descriptor;
+}
+
 const struct stmmac_desc_ops enh_desc_ops = {
 	.tx_status = enh_desc_get_tx_status,
 	.rx_status = enh_desc_get_rx_status,
@@ -388,9 +415,12 @@ const struct stmmac_desc_ops enh_desc_ops = {
 	.release_tx_desc = enh_desc_release_tx_desc,
 	.prepare_tx_desc = enh_desc_prepare_tx_desc,
 	.clear_tx_ic = enh_desc_clear_tx_ic,
+	.set_rx_ic = enh_desc_set_rx_ic,
 	.close_tx_desc = enh_desc_close_tx_desc,
 	.get_tx_ls = enh_desc_get_tx_ls,
 	.set_tx_owner = enh_desc_set_tx_owner,
 	.set_rx_owner = enh_desc_set_rx_owner,
 	.get_rx_frame_len = enh_desc_get_rx_frame_len,
+	.get_rx_fs = enh_desc_get_rx_fs,
+	.get_rx_ls = enh_desc_get_rx_ls,
 };
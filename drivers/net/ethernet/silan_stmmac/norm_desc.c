@@ -75,13 +75,6 @@ static int ndesc_get_rx_status(void *data, struct stmmac_extra_stats *x,
 	int ret = csum_none;
 	struct net_device_stats *stats = (struct net_device_stats *)data;
 
-	if (unlikely(p->des01.rx.last_descriptor == 0)) {
-		pr_warning("ndesc Error: Oversized Ethernet "
-			   "frame spanned multiple buffers\n");
-		stats->rx_length_errors++;
-		return discard_frame;
-	}
-
 	if (unlikely(p->des01.rx.error_summary)) {
 		if (unlikely(p->des01.rx.descriptor_error))
 			x->rx_desc++;
@@ -120,12 +113,12 @@ static int ndesc_get_rx_status(void *data, struct stmmac_extra_stats *x,
 }
 
 static void ndesc_init_rx_desc(struct dma_desc *p, unsigned int ring_size,
-			       int disable_rx_ic)
+			       int disable_rx_ic, int bfsize)
 {
 	int i;
 	for (i = 0; i < ring_size; i++) {
 		p->des01.rx.own = 1;
-		p->des01.rx.buffer1_size = BUF_SIZE_2KiB - 1;
+		p->des01.rx.buffer1_size = min(bfsize, BUF_SIZE_2KiB - 1);
 		if (i == ring_size - 1)
 			p->des01.rx.end_ring = 1;
 		if (disable_rx_ic)
@@ -191,6 +184,11 @@ static void ndesc_clear_tx_ic(struct dma_desc *p)
 	p->des01.tx.interrupt = 0;
 }
 
+static void ndesc_set_rx_ic(struct dma_desc *p, int ic)
+{
+	p->des01.rx.disable_ic = !ic;
+}
+
 static void ndesc_close_tx_desc(struct dma_desc *p)
 {
 	p->des01.tx.last_segment = 1;
@@ -202,6 +200,16 @@ static int ndesc_get_rx_frame_len(struct dma_desc *p)
 	return p->des01.rx.frame_length;
 }
 
+static int ndesc_get_rx_fs(struct dma_desc *p)
+{
+	return p->des01.rx.first_descriptor;
+}
+
+static int ndesc_get_rx_ls(struct dma_desc *p)
+{
+	return p->des01.rx.last_descriptor;
+}
+
 const struct stmmac_desc_ops ndesc_ops = {
 	.tx_status = ndesc_get_tx_status,
 	.rx_status = ndesc_get_rx_status,
@@ -213,9 +221,12 @@ const struct stmmac_desc_ops ndesc_ops = {
 	.release_tx_desc = ndesc_release_tx_desc,
 	.prepare_tx_desc = ndesc_prepare_tx_desc,
 	.clear_tx_ic = ndesc_clear_tx_ic,
+	.set_rx_ic = ndesc_set_rx_ic,
 	.close_tx_desc = ndesc_close_tx_desc,
 	.get_tx_ls = ndesc_get_tx_ls,
 	.set_tx_owner = ndesc_set_tx_owner,
 	.set_rx_owner = ndesc_set_rx_owner,
 	.get_rx_frame_len = ndesc_get_rx_frame_len,
+	.get_rx_fs = ndesc_get_rx_fs,
+	.get_rx_ls = ndesc_get_rx_ls,
 };
@@ -25,8 +25,17 @@
 #ifndef _SILAN_GMAC_ENHANCE_H
 #define _SILAN_GMAC_ENHANCE_H
 
-/* NAPI state */
-#define NAPI_OFF            0
-#define NAPI_ON             1
+/* Tx completion strategies (/sys/class/net/ethX/tx_completion) */
+enum silan_gmac_tx_completion {
+	TX_COMPLETION_IRQ = 0,	/* "irq": Tx interrupt on completion */
+	TX_COMPLETION_POSTCHK,	/* "postchk": xmit schedules the Tx NAPI */
+	TX_COMPLETION_TIMER,	/* "timer": only the Tx timer reclaims */
+};
+
+#ifdef CONFIG_SILAN_GMAC_TX_POSTCHK
+#define TX_COMPLETION_DEFAULT	TX_COMPLETION_POSTCHK
+#else
+#define TX_COMPLETION_DEFAULT	TX_COMPLETION_IRQ
+#endif
 
 #endif /* _SILAN_GMAC_ENHANCE_H */
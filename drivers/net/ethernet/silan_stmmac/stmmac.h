@@ -26,32 +26,168 @@
 #define DRV_MODULE_VERSION	"Nov_2010"
 #include <linux/platform_device.h>
 #include <linux/stmmac.h>
+#include <linux/dim.h>
+#include <linux/u64_stats_sync.h>
+#include <linux/bpf.h>
+#include <net/page_pool.h>
+#include <net/xdp.h>
+#include <net/xdp_sock_drv.h>
 
 #include "common.h"
+#include "silan_gmac_enhance.h"
 #ifdef CONFIG_STMMAC_TIMER
 #include "stmmac_timer.h"
 #endif
+#ifdef CONFIG_SILAN_GMAC_FWD
+#include "stmmac_fwd.h"
+#endif
+#include "stmmac_mmc.h"
+#include "stmmac_hist.h"
+
+/* RX buffer: a page_pool fragment kept DMA mapped while it is in the ring,
+ * or a UMEM frame in AF_XDP zero-copy mode. The descriptors live in
+ * uncached coherent memory: the driver keeps what it needs here and only
+ * reads the status word of the descriptor. */
+struct stmmac_rx_buffer {
+	struct page *page;
+	unsigned int page_offset;
+	struct xdp_buff *xdp;
+	dma_addr_t dma;		/* address given to the DMA (des2) */
+};
+
+/* What a TX descriptor carries, so that the completion knows how to
+ * release it */
+enum stmmac_txbuf_type {
+	STMMAC_TXBUF_T_SKB = 0,
+	STMMAC_TXBUF_T_XDP_TX,		/* RX page sent back, no own mapping */
+	STMMAC_TXBUF_T_XDP_NDO,		/* frame mapped by ndo_xdp_xmit */
+	STMMAC_TXBUF_T_XSK_TX,		/* UMEM frame of an AF_XDP socket */
+	STMMAC_TXBUF_T_SLOT,		/* copy in the coherent TX slot */
+};
+
+/* Software shadow of a TX descriptor, for the same reason as the RX one:
+ * the completion never reads the buffer fields of the descriptor back */
+struct stmmac_tx_buffer {
+	union {
+		struct sk_buff *skb;	/* STMMAC_TXBUF_T_SKB */
+		struct xdp_frame *xdpf;	/* STMMAC_TXBUF_T_XDP_* */
+	};
+	dma_addr_t dma;		/* own mapping to release, 0 if none */
+	unsigned int len;	/* length of that mapping */
+	u16 copy_len;		/* frame copied in the TX slot */
+	u8 type;		/* enum stmmac_txbuf_type */
+	u8 map_as_page;		/* mapped by dma_map_page */
+};
+
+/* Every TX descriptor owns a slot of DMA coherent memory: it takes the
+ * headers of a TSO segment or a whole frame below the TX copybreak */
+#define STMMAC_TX_SLOT_SIZE	256
+
+/* Bounds of the ring sizes set through ethtool -G; the TX ring has to
+ * hold at least a couple of maximally fragmented frames. The sizes are
+ * rounded up to a power of two. */
+#define STMMAC_MIN_RING_SIZE	64
+#define STMMAC_MAX_RING_SIZE	4096
+
+/* The RX interrupt watchdog is 8 bits wide */
+#define STMMAC_MAX_DMA_RIWT	0xff
+
+/* Per packet counters: 64 bit wide even on the 32 bit cores, read without
+ * stopping the datapath through their u64_stats_sync. Each block has one
+ * writer at a time: the RX NAPI, the transmit paths (TX queue lock held)
+ * and the TX completion. The error counters are rare and stay in
+ * dev->stats and struct stmmac_extra_stats. */
+struct stmmac_rx_stats {
+	struct u64_stats_sync syncp;
+	u64_stats_t packets;
+	u64_stats_t bytes;
+	u64_stats_t pkt_n;		/* descriptors processed */
+	u64_stats_t poll_n;
+	u64_stats_t copybreak_n;
+	u64_stats_t scatter_n;
+	u64_stats_t fwd_n;
+	u64_stats_t xdp_drop;
+	u64_stats_t xdp_tx;
+	u64_stats_t xdp_redirect;
+	u64_stats_t sync_saved_bytes;
+};
+
+struct stmmac_tx_stats {
+	struct u64_stats_sync syncp;
+	u64_stats_t bytes;
+	u64_stats_t copybreak_n;
+	u64_stats_t copybreak_bytes;
+	u64_stats_t tso_frames;
+	u64_stats_t tso_segs;
+	u64_stats_t map_err;
+	u64_stats_t xdp_xmit;
+	u64_stats_t xsk_xmit;
+};
+
+struct stmmac_txc_stats {
+	struct u64_stats_sync syncp;
+	u64_stats_t packets;
+	u64_stats_t poll_n;
+};
+
+#define stmmac_stats_add(s, m, v)			\
+	do {						\
+		u64_stats_update_begin(&(s)->syncp);	\
+		u64_stats_add(&(s)->m, v);		\
+		u64_stats_update_end(&(s)->syncp);	\
+	} while (0)
+#define stmmac_stats_inc(s, m)	stmmac_stats_add(s, m, 1)
+
+/* Driver private flags (ethtool --set-priv-flags) */
+#define STMMAC_PRIV_FLAG_RX_PARTIAL_SYNC	(1 << 0)
+#define STMMAC_PRIV_FLAG_FWD			(1 << 1)
 
 struct stmmac_priv {
 	/* Frequently used values are kept adjacent for cache effect */
 	struct dma_desc *dma_tx ____cacheline_aligned;
 	dma_addr_t dma_tx_phy;
-	struct sk_buff **tx_skbuff;
+	struct stmmac_tx_buffer *tx_buf;
+	char *tx_slots;
+	dma_addr_t tx_slots_phy;
+	unsigned int tx_copybreak;
 	unsigned int cur_tx;
 	unsigned int dirty_tx;
 	unsigned int dma_tx_size;
-	int tx_coalesce;
-#ifdef CONFIG_SILAN_GMAC_TX_POSTCHK
-    unsigned int napi_state;
-#endif
+	u32 tx_coal_frames;
+	u32 tx_coal_timer;
+	unsigned int tx_count_frames;
+	struct timer_list txtimer;
+	unsigned int tx_completion;
+	/* TX ring reset after an error, see stmmac_tx_err_work */
+	struct work_struct tx_err_work;
+	struct stmmac_tx_stats tx_stats;
+	struct stmmac_txc_stats txc_stats;
 	int platform_id;
 
 	struct dma_desc *dma_rx ;
 	unsigned int cur_rx;
 	unsigned int dirty_rx;
-	struct sk_buff **rx_skbuff;
-	dma_addr_t *rx_skbuff_dma;
-	struct sk_buff_head rx_recycle;
+	struct stmmac_rx_buffer *rx_buf;
+	struct page_pool *page_pool;
+	unsigned int rx_truesize;
+	unsigned int rx_headroom;
+	enum dma_data_direction rx_dma_dir;
+	struct bpf_prog *xdp_prog;
+	struct xdp_rxq_info xdp_rxq;
+	struct xsk_buff_pool *xsk_pool;
+	/* Frame spanning several RX buffers, kept across NAPI polls */
+	struct sk_buff *rx_skb;
+	bool rx_skb_drop;
+	unsigned int rx_copybreak;
+	u32 rx_riwt;
+	u32 rx_coal_frames;
+	bool rx_coal_update;
+	struct dim rx_dim;
+	struct dim tx_dim;
+	bool rx_dim_enabled;
+	bool tx_dim_enabled;
+	u32 priv_flags;
+	struct stmmac_rx_stats rx_stats;
 
 	struct net_device *dev;
 	dma_addr_t dma_rx_phy;
@@ -62,7 +198,14 @@ struct stmmac_priv {
 	void __iomem *ioaddr;
 
 	struct stmmac_extra_stats xstats;
+	/* MMC totals, folded by mmc_timer */
+	struct stmmac_counters mmc;
+	struct timer_list mmc_timer;
+	spinlock_t mmc_lock;
 	struct napi_struct napi;
+	struct napi_struct tx_napi;
+	/* Serializes the masking of the RX/TX interrupts */
+	spinlock_t irq_lock;
 
 	phy_interface_t phy_interface;
 	int phy_addr;
@@ -86,17 +229,28 @@ struct stmmac_priv {
 	int wolenabled;
 #ifdef CONFIG_STMMAC_TIMER
 	struct stmmac_timer *tm;
-#endif
-#ifdef STMMAC_VLAN_TAG_USED
-	struct vlan_group *vlgrp;
+	unsigned int tmrate;
 #endif
 	struct plat_stmmacenet_data *plat;
 	struct clk *clk;
+	/* To turn rx_sync_saved_bytes into a rate, owned by mmc_timer */
+	u64 rx_sync_saved_last;
+	unsigned long rx_sync_stamp;
+#ifdef CONFIG_SILAN_GMAC_POLL_HIST
+	struct stmmac_poll_hist hist;
+	struct dentry *hist_dir;
+#endif
 };
 
 extern int stmmac_mdio_unregister(struct net_device *ndev);
 extern int stmmac_mdio_register(struct net_device *ndev);
 extern void stmmac_set_ethtool_ops(struct net_device *netdev);
+extern void stmmac_rx_coalesce_apply(struct stmmac_priv *priv);
+extern void stmmac_dim_enable(struct stmmac_priv *priv, bool rx, bool tx);
+extern u32 stmmac_usec2riwt(struct stmmac_priv *priv, u32 usec);
+extern u32 stmmac_riwt2usec(struct stmmac_priv *priv, u32 riwt);
+extern int stmmac_reinit_rings(struct net_device *dev, unsigned int rxsize,
+			       unsigned int txsize);
 extern const struct stmmac_desc_ops enh_desc_ops;
 extern const struct stmmac_desc_ops ndesc_ops;
 
@@ -22,10 +22,12 @@
   Author: Giuseppe Cavallaro <peppe.cavallaro@st.com>
 *******************************************************************************/
 
+#include <linux/clk.h>
 #include <linux/etherdevice.h>
 #include <linux/ethtool.h>
 #include <linux/mii.h>
 #include <linux/phy.h>
+#include <linux/log2.h>
 
 #include "stmmac.h"
 #include "dwmac_dma.h"
@@ -34,6 +36,9 @@
 #define MAC100_ETHTOOL_NAME	"st_mac100"
 #define GMAC_ETHTOOL_NAME	"st_gmac"
 
+/* Coalescing limits */
+#define STMMAC_MAX_COAL_FRAMES	256
+
 struct stmmac_stats {
 	char stat_string[ETH_GSTRING_LEN];
 	int sizeof_stat;
@@ -41,7 +46,7 @@ struct stmmac_stats {
 };
 
 #define STMMAC_STAT(m)	\
-	{ #m, FIELD_SIZEOF(struct stmmac_extra_stats, m),	\
+	{ #m, sizeof_field(struct stmmac_extra_stats, m),	\
 	offsetof(struct stmmac_priv, xstats.m)}
 
 static const struct  stmmac_stats stmmac_gstrings_stats[] = {
@@ -81,13 +86,97 @@ static const struct  stmmac_stats stmmac_gstrings_stats[] = {
 	STMMAC_STAT(tx_early_irq),
 	STMMAC_STAT(fatal_bus_error_irq),
 	STMMAC_STAT(threshold),
-	STMMAC_STAT(tx_pkt_n),
-	STMMAC_STAT(rx_pkt_n),
-	STMMAC_STAT(poll_n),
 	STMMAC_STAT(sched_timer_n),
 	STMMAC_STAT(normal_irq_n),
+	STMMAC_STAT(rx_sync_saved_bps),
+	STMMAC_STAT(rx_dim_profile),
+	STMMAC_STAT(rx_dim_transitions),
+	STMMAC_STAT(tx_dim_profile),
+	STMMAC_STAT(tx_dim_transitions),
+};
+#define STMMAC_COLD_STATS_LEN ARRAY_SIZE(stmmac_gstrings_stats)
+
+/* Per packet counters, read under the u64_stats_sync of their block */
+#define STMMAC_HOT_STAT(s, m, name)	\
+	{ name, sizeof(u64_stats_t), offsetof(struct stmmac_priv, s.m) }
+
+static const struct stmmac_stats stmmac_gstrings_rx_stats[] = {
+	STMMAC_HOT_STAT(rx_stats, pkt_n, "rx_pkt_n"),
+	STMMAC_HOT_STAT(rx_stats, poll_n, "poll_n"),
+	STMMAC_HOT_STAT(rx_stats, sync_saved_bytes, "rx_sync_saved_bytes"),
+	STMMAC_HOT_STAT(rx_stats, copybreak_n, "rx_copybreak_n"),
+	STMMAC_HOT_STAT(rx_stats, xdp_drop, "rx_xdp_drop"),
+	STMMAC_HOT_STAT(rx_stats, xdp_tx, "rx_xdp_tx"),
+	STMMAC_HOT_STAT(rx_stats, xdp_redirect, "rx_xdp_redirect"),
+	STMMAC_HOT_STAT(rx_stats, fwd_n, "rx_fwd_n"),
+	STMMAC_HOT_STAT(rx_stats, scatter_n, "rx_scatter_n"),
+};
+
+static const struct stmmac_stats stmmac_gstrings_tx_stats[] = {
+	STMMAC_HOT_STAT(tx_stats, xdp_xmit, "tx_xdp_xmit"),
+	STMMAC_HOT_STAT(tx_stats, xsk_xmit, "tx_xsk_xmit"),
+	STMMAC_HOT_STAT(tx_stats, copybreak_n, "tx_copybreak_n"),
+	STMMAC_HOT_STAT(tx_stats, copybreak_bytes, "tx_copybreak_bytes"),
+	STMMAC_HOT_STAT(tx_stats, tso_frames, "tx_tso_frames"),
+	STMMAC_HOT_STAT(tx_stats, tso_segs, "tx_tso_segs"),
+	STMMAC_HOT_STAT(tx_stats, map_err, "tx_map_err"),
+};
+
+static const struct stmmac_stats stmmac_gstrings_txc_stats[] = {
+	STMMAC_HOT_STAT(txc_stats, packets, "tx_pkt_n"),
+	STMMAC_HOT_STAT(txc_stats, poll_n, "tx_poll_n"),
+};
+
+#define STMMAC_STATS_LEN (STMMAC_COLD_STATS_LEN +			\
+			  ARRAY_SIZE(stmmac_gstrings_rx_stats) +	\
+			  ARRAY_SIZE(stmmac_gstrings_tx_stats) +	\
+			  ARRAY_SIZE(stmmac_gstrings_txc_stats))
+
+/* GMAC MMC counters, copied from a snapshot of the totals */
+#define STMMAC_MMC_STAT(m)	\
+	{ #m, sizeof(u64), offsetof(struct stmmac_counters, m) }
+
+static const struct stmmac_stats stmmac_gstrings_mmc[] = {
+	STMMAC_MMC_STAT(mmc_tx_octetcount_gb),
+	STMMAC_MMC_STAT(mmc_tx_framecount_gb),
+	STMMAC_MMC_STAT(mmc_tx_octetcount_g),
+	STMMAC_MMC_STAT(mmc_tx_framecount_g),
+	STMMAC_MMC_STAT(mmc_tx_underflow_error),
+	STMMAC_MMC_STAT(mmc_tx_latecol),
+	STMMAC_MMC_STAT(mmc_tx_exesscol),
+	STMMAC_MMC_STAT(mmc_tx_carrier_error),
+	STMMAC_MMC_STAT(mmc_tx_pause_frame),
+	STMMAC_MMC_STAT(mmc_rx_framecount_gb),
+	STMMAC_MMC_STAT(mmc_rx_octetcount_gb),
+	STMMAC_MMC_STAT(mmc_rx_octetcount_g),
+	STMMAC_MMC_STAT(mmc_rx_unicast_g),
+	STMMAC_MMC_STAT(mmc_rx_multicastframe_g),
+	STMMAC_MMC_STAT(mmc_rx_broadcastframe_g),
+	STMMAC_MMC_STAT(mmc_rx_crc_error),
+	STMMAC_MMC_STAT(mmc_rx_align_error),
+	STMMAC_MMC_STAT(mmc_rx_run_error),
+	STMMAC_MMC_STAT(mmc_rx_jabber_error),
+	STMMAC_MMC_STAT(mmc_rx_oversize_g),
+	STMMAC_MMC_STAT(mmc_rx_length_error),
+	STMMAC_MMC_STAT(mmc_rx_pause_frames),
+	STMMAC_MMC_STAT(mmc_rx_fifo_overflow),
+	STMMAC_MMC_STAT(mmc_rx_watchdog_error),
 };
-#define STMMAC_STATS_LEN ARRAY_SIZE(stmmac_gstrings_stats)
+#define STMMAC_MMC_STATS_LEN ARRAY_SIZE(stmmac_gstrings_mmc)
+
+/* The MAC100 has no MMC module */
+static int stmmac_stats_len(struct stmmac_priv *priv)
+{
+	if (priv->plat->has_gmac)
+		return STMMAC_STATS_LEN + STMMAC_MMC_STATS_LEN;
+	return STMMAC_STATS_LEN;
+}
+
+static const char stmmac_priv_flags_strings[][ETH_GSTRING_LEN] = {
+	"rx-partial-sync",
+	"fwd",
+};
+#define STMMAC_PRIV_FLAGS_LEN ARRAY_SIZE(stmmac_priv_flags_strings)
 
 static void stmmac_ethtool_getdrvinfo(struct net_device *dev,
 				      struct ethtool_drvinfo *info)
@@ -101,15 +190,16 @@ static void stmmac_ethtool_getdrvinfo(struct net_device *dev,
 
 	strcpy(info->version, DRV_MODULE_VERSION);
 	info->fw_version[0] = '\0';
-	info->n_stats = STMMAC_STATS_LEN;
+	info->n_stats = stmmac_stats_len(priv);
+	info->n_priv_flags = STMMAC_PRIV_FLAGS_LEN;
 }
 
-static int stmmac_ethtool_getsettings(struct net_device *dev,
-				      struct ethtool_cmd *cmd)
+static int stmmac_ethtool_get_link_ksettings(struct net_device *dev,
+					     struct ethtool_link_ksettings *cmd)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
 	struct phy_device *phy = priv->phydev;
-	int rc;
+
 	if (phy == NULL) {
 		pr_err("%s: %s: PHY is not registered\n",
 		       __func__, dev->name);
@@ -120,25 +210,20 @@ static int stmmac_ethtool_getsettings(struct net_device *dev,
 		"link speed / duplex setting\n", dev->name);
 		return -EBUSY;
 	}
-	cmd->transceiver = XCVR_INTERNAL;
-	spin_lock_irq(&priv->lock);
-	rc = phy_ethtool_gset(phy, cmd);
-	spin_unlock_irq(&priv->lock);
-	return rc;
+	/* phylib serializes against the PHY state machine itself */
+	phy_ethtool_ksettings_get(phy, cmd);
+	return 0;
 }
 
-static int stmmac_ethtool_setsettings(struct net_device *dev,
-				      struct ethtool_cmd *cmd)
+static int
+stmmac_ethtool_set_link_ksettings(struct net_device *dev,
+				  const struct ethtool_link_ksettings *cmd)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
-	struct phy_device *phy = priv->phydev;
-	int rc;
-
-	spin_lock(&priv->lock);
-	rc = phy_ethtool_sset(phy, cmd);
-	spin_unlock(&priv->lock);
 
-	return rc;
+	if (priv->phydev == NULL)
+		return -ENODEV;
+	return phy_ethtool_ksettings_set(priv->phydev, cmd);
 }
 
 static u32 stmmac_ethtool_getmsglevel(struct net_device *dev)
@@ -236,38 +321,77 @@ stmmac_set_pauseparam(struct net_device *netdev,
 	priv->flow_ctrl = new_pause;
 	phy->autoneg = pause->autoneg;
 
-	if (phy->autoneg) {
-		if (netif_running(netdev))
-			ret = phy_start_aneg(phy);
-	} else
+	if (!phy->autoneg)
 		priv->hw->mac->flow_ctrl(priv->ioaddr, phy->duplex,
 					 priv->flow_ctrl, priv->pause);
 	spin_unlock(&priv->lock);
+
+	/* phy_start_aneg takes the PHY mutex: not under the spinlock */
+	if (phy->autoneg && netif_running(netdev))
+		ret = phy_start_aneg(phy);
 	return ret;
 }
 
+/* Copy one block of per packet counters, retrying if a writer ran meanwhile */
+static u64 *stmmac_get_hot_stats(struct stmmac_priv *priv,
+				 struct u64_stats_sync *syncp,
+				 const struct stmmac_stats *stats, int n,
+				 u64 *data)
+{
+	unsigned int start;
+	int i;
+
+	do {
+		start = u64_stats_fetch_begin(syncp);
+		for (i = 0; i < n; i++)
+			data[i] = u64_stats_read((u64_stats_t *)
+					((char *)priv + stats[i].stat_offset));
+	} while (u64_stats_fetch_retry(syncp, start));
+
+	return data + n;
+}
+
 static void stmmac_get_ethtool_stats(struct net_device *dev,
 				 struct ethtool_stats *dummy, u64 *data)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
+	struct stmmac_counters mmc;
 	int i;
 
-	/* Update HW stats if supported */
-	priv->hw->dma->dma_diagnostic_fr(&dev->stats, (void *) &priv->xstats,
-					 priv->ioaddr);
+	/* Update HW stats: MMC and DMA missed frame counters. The
+	 * rx_sync_saved_bps rate is left to the collector timer. */
+	stmmac_mmc_read(priv, &mmc);
 
-	for (i = 0; i < STMMAC_STATS_LEN; i++) {
+	for (i = 0; i < STMMAC_COLD_STATS_LEN; i++) {
 		char *p = (char *)priv + stmmac_gstrings_stats[i].stat_offset;
 		data[i] = (stmmac_gstrings_stats[i].sizeof_stat ==
 		sizeof(u64)) ? (*(u64 *)p) : (*(u32 *)p);
 	}
+	data += STMMAC_COLD_STATS_LEN;
+
+	data = stmmac_get_hot_stats(priv, &priv->rx_stats.syncp,
+				    stmmac_gstrings_rx_stats,
+				    ARRAY_SIZE(stmmac_gstrings_rx_stats), data);
+	data = stmmac_get_hot_stats(priv, &priv->tx_stats.syncp,
+				    stmmac_gstrings_tx_stats,
+				    ARRAY_SIZE(stmmac_gstrings_tx_stats), data);
+	data = stmmac_get_hot_stats(priv, &priv->txc_stats.syncp,
+				    stmmac_gstrings_txc_stats,
+				    ARRAY_SIZE(stmmac_gstrings_txc_stats), data);
+
+	if (priv->plat->has_gmac)
+		for (i = 0; i < STMMAC_MMC_STATS_LEN; i++)
+			data[i] = *(u64 *)((char *)&mmc +
+					   stmmac_gstrings_mmc[i].stat_offset);
 }
 
 static int stmmac_get_sset_count(struct net_device *netdev, int sset)
 {
 	switch (sset) {
 	case ETH_SS_STATS:
-		return STMMAC_STATS_LEN;
+		return stmmac_stats_len(netdev_priv(netdev));
+	case ETH_SS_PRIV_FLAGS:
+		return STMMAC_PRIV_FLAGS_LEN;
 	default:
 		return -EOPNOTSUPP;
 	}
@@ -275,16 +399,43 @@ static int stmmac_get_sset_count(struct net_device *netdev, int sset)
 
 static void stmmac_get_strings(struct net_device *dev, u32 stringset, u8 *data)
 {
+	struct stmmac_priv *priv = netdev_priv(dev);
 	int i;
 	u8 *p = data;
 
 	switch (stringset) {
 	case ETH_SS_STATS:
-		for (i = 0; i < STMMAC_STATS_LEN; i++) {
+		for (i = 0; i < STMMAC_COLD_STATS_LEN; i++) {
 			memcpy(p, stmmac_gstrings_stats[i].stat_string,
 				ETH_GSTRING_LEN);
 			p += ETH_GSTRING_LEN;
 		}
+		for (i = 0; i < ARRAY_SIZE(stmmac_gstrings_rx_stats); i++) {
+			memcpy(p, stmmac_gstrings_rx_stats[i].stat_string,
+				ETH_GSTRING_LEN);
+			p += ETH_GSTRING_LEN;
+		}
+		for (i = 0; i < ARRAY_SIZE(stmmac_gstrings_tx_stats); i++) {
+			memcpy(p, stmmac_gstrings_tx_stats[i].stat_string,
+				ETH_GSTRING_LEN);
+			p += ETH_GSTRING_LEN;
+		}
+		for (i = 0; i < ARRAY_SIZE(stmmac_gstrings_txc_stats); i++) {
+			memcpy(p, stmmac_gstrings_txc_stats[i].stat_string,
+				ETH_GSTRING_LEN);
+			p += ETH_GSTRING_LEN;
+		}
+		if (!priv->plat->has_gmac)
+			break;
+		for (i = 0; i < STMMAC_MMC_STATS_LEN; i++) {
+			memcpy(p, stmmac_gstrings_mmc[i].stat_string,
+				ETH_GSTRING_LEN);
+			p += ETH_GSTRING_LEN;
+		}
+		break;
+	case ETH_SS_PRIV_FLAGS:
+		memcpy(p, stmmac_priv_flags_strings,
+		       sizeof(stmmac_priv_flags_strings));
 		break;
 	default:
 		WARN_ON(1);
@@ -332,11 +483,202 @@ static int stmmac_set_wol(struct net_device *dev, struct ethtool_wolinfo *wol)
 	return 0;
 }
 
+static void stmmac_get_ringparam(struct net_device *dev,
+				 struct ethtool_ringparam *ring,
+				 struct kernel_ethtool_ringparam *kernel_ring,
+				 struct netlink_ext_ack *extack)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	ring->rx_max_pending = STMMAC_MAX_RING_SIZE;
+	ring->tx_max_pending = STMMAC_MAX_RING_SIZE;
+	ring->rx_pending = priv->dma_rx_size;
+	ring->tx_pending = priv->dma_tx_size;
+}
+
+static int stmmac_set_ringparam(struct net_device *dev,
+				struct ethtool_ringparam *ring,
+				struct kernel_ethtool_ringparam *kernel_ring,
+				struct netlink_ext_ack *extack)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	unsigned int rxsize, txsize;
+
+	if (ring->rx_mini_pending || ring->rx_jumbo_pending)
+		return -EINVAL;
+	if ((ring->rx_pending < STMMAC_MIN_RING_SIZE) ||
+	    (ring->rx_pending > STMMAC_MAX_RING_SIZE) ||
+	    (ring->tx_pending < STMMAC_MIN_RING_SIZE) ||
+	    (ring->tx_pending > STMMAC_MAX_RING_SIZE))
+		return -EINVAL;
+	/* The ring indexes are masked: powers of two only */
+	rxsize = roundup_pow_of_two(ring->rx_pending);
+	txsize = roundup_pow_of_two(ring->tx_pending);
+
+	if ((rxsize == priv->dma_rx_size) && (txsize == priv->dma_tx_size))
+		return 0;
+
+	return stmmac_reinit_rings(dev, rxsize, txsize);
+}
+
+static int stmmac_get_coalesce(struct net_device *dev,
+			       struct ethtool_coalesce *ec,
+			       struct kernel_ethtool_coalesce *kernel_coal,
+			       struct netlink_ext_ack *extack)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	ec->use_adaptive_rx_coalesce = priv->rx_dim_enabled;
+	ec->use_adaptive_tx_coalesce = priv->tx_dim_enabled;
+	ec->tx_coalesce_usecs = priv->tx_coal_timer;
+	ec->tx_max_coalesced_frames = priv->tx_coal_frames;
+	ec->rx_max_coalesced_frames = priv->rx_coal_frames;
+	if (priv->rx_riwt)
+		ec->rx_coalesce_usecs = stmmac_riwt2usec(priv, priv->rx_riwt);
+#ifdef CONFIG_STMMAC_TIMER
+	/* Period of the mitigation timer */
+	ec->rx_coalesce_usecs_irq = USEC_PER_SEC / priv->tmrate;
+#endif
+
+	return 0;
+}
+
+static int stmmac_set_coalesce(struct net_device *dev,
+			       struct ethtool_coalesce *ec,
+			       struct kernel_ethtool_coalesce *kernel_coal,
+			       struct netlink_ext_ack *extack)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	u32 riwt = 0;
+
+	if (ec->rx_coalesce_usecs || ec->use_adaptive_rx_coalesce) {
+		/* No watchdog on the mac10/100 */
+		if (!priv->hw->dma->rx_watchdog ||
+		    clk_get_rate(priv->clk) < 1000000)
+			return -EOPNOTSUPP;
+	}
+	if (ec->rx_coalesce_usecs) {
+		riwt = stmmac_usec2riwt(priv, ec->rx_coalesce_usecs);
+		if (riwt > STMMAC_MAX_DMA_RIWT)
+			return -EINVAL;
+	}
+
+	if ((ec->rx_max_coalesced_frames > priv->dma_rx_size) ||
+	    (ec->tx_max_coalesced_frames > STMMAC_MAX_COAL_FRAMES) ||
+	    (ec->tx_max_coalesced_frames > priv->dma_tx_size / 2))
+		return -EINVAL;
+
+	/* Frames without interrupt need the timer to be reclaimed */
+	if ((ec->tx_max_coalesced_frames > 1) && !ec->tx_coalesce_usecs)
+		return -EINVAL;
+
+#ifdef CONFIG_STMMAC_TIMER
+	if (ec->rx_coalesce_usecs_irq) {
+		unsigned int freq = USEC_PER_SEC / ec->rx_coalesce_usecs_irq;
+
+		if (!freq)
+			return -EINVAL;
+		/* The running hrtimer picks it up at its next period */
+		priv->tmrate = freq;
+		WRITE_ONCE(priv->tm->freq, freq);
+	}
+#endif
+
+	priv->tx_coal_frames = ec->tx_max_coalesced_frames;
+	priv->tx_coal_timer = ec->tx_coalesce_usecs;
+	priv->rx_coal_frames = ec->rx_max_coalesced_frames;
+	priv->rx_riwt = riwt;
+	stmmac_rx_coalesce_apply(priv);
+
+	/* The static values above hold until the next DIM decision */
+	stmmac_dim_enable(priv, ec->use_adaptive_rx_coalesce,
+			  ec->use_adaptive_tx_coalesce);
+
+	return 0;
+}
+
+static u32 stmmac_get_priv_flags(struct net_device *dev)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	return priv->priv_flags;
+}
+
+static int stmmac_set_priv_flags(struct net_device *dev, u32 flags)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	if (flags & ~((1 << STMMAC_PRIV_FLAGS_LEN) - 1))
+		return -EINVAL;
+#ifndef CONFIG_SILAN_GMAC_FWD
+	if (flags & STMMAC_PRIV_FLAG_FWD)
+		return -EOPNOTSUPP;
+#endif
+
+	/* The flags are sampled per frame by stmmac_rx */
+	priv->priv_flags = flags;
+#ifdef CONFIG_SILAN_GMAC_FWD
+	/* Its stations are no longer learnt: forget them */
+	if (!(flags & STMMAC_PRIV_FLAG_FWD))
+		stmmac_fwd_flush(stmmac_fwd_port(priv));
+#endif
+
+	return 0;
+}
+
+static int stmmac_get_tunable(struct net_device *dev,
+			      const struct ethtool_tunable *tuna, void *data)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	switch (tuna->id) {
+	case ETHTOOL_RX_COPYBREAK:
+		*(u32 *)data = priv->rx_copybreak;
+		break;
+	case ETHTOOL_TX_COPYBREAK:
+		*(u32 *)data = priv->tx_copybreak;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int stmmac_set_tunable(struct net_device *dev,
+			      const struct ethtool_tunable *tuna,
+			      const void *data)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	switch (tuna->id) {
+	case ETHTOOL_RX_COPYBREAK:
+		priv->rx_copybreak = *(u32 *)data;
+		break;
+	case ETHTOOL_TX_COPYBREAK:
+		/* The frame has to fit the TX slot */
+		if (*(u32 *)data > STMMAC_TX_SLOT_SIZE)
+			return -EINVAL;
+		WRITE_ONCE(priv->tx_copybreak, *(u32 *)data);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static struct ethtool_ops stmmac_ethtool_ops = {
+	.supported_coalesce_params = ETHTOOL_COALESCE_USECS |
+				     ETHTOOL_COALESCE_MAX_FRAMES |
+#ifdef CONFIG_STMMAC_TIMER
+				     ETHTOOL_COALESCE_RX_USECS_IRQ |
+#endif
+				     ETHTOOL_COALESCE_USE_ADAPTIVE,
 	.begin = stmmac_check_if_running,
 	.get_drvinfo = stmmac_ethtool_getdrvinfo,
-	.get_settings = stmmac_ethtool_getsettings,
-	.set_settings = stmmac_ethtool_setsettings,
+	.get_link_ksettings = stmmac_ethtool_get_link_ksettings,
+	.set_link_ksettings = stmmac_ethtool_set_link_ksettings,
 	.get_msglevel = stmmac_ethtool_getmsglevel,
 	.set_msglevel = stmmac_ethtool_setmsglevel,
 	.get_regs = stmmac_ethtool_gregs,
@@ -349,6 +691,14 @@ static struct ethtool_ops stmmac_ethtool_ops = {
 	.get_wol = stmmac_get_wol,
 	.set_wol = stmmac_set_wol,
 	.get_sset_count	= stmmac_get_sset_count,
+	.get_priv_flags = stmmac_get_priv_flags,
+	.set_priv_flags = stmmac_set_priv_flags,
+	.get_tunable = stmmac_get_tunable,
+	.set_tunable = stmmac_set_tunable,
+	.get_ringparam = stmmac_get_ringparam,
+	.set_ringparam = stmmac_set_ringparam,
+	.get_coalesce = stmmac_get_coalesce,
+	.set_coalesce = stmmac_set_coalesce,
 };
 
 void stmmac_set_ethtool_ops(struct net_device *netdev)
@@ -0,0 +1,153 @@
+/*******************************************************************************
+  Silan GMAC: forwarding between ETH0 and ETH1 inside the driver
+
+  Copyright (C) 2013 Silan Microelectronics Ltd
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms and conditions of the GNU General Public License,
+  version 2, as published by the Free Software Foundation.
+
+  This program is distributed in the hope it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU General Public License along with
+  this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+
+  The full GNU General Public License is included in this distribution in
+  the file called "COPYING".
+
+  The two controllers learn, from the source address of the frames they
+  receive, on which side each station sits. A unicast frame whose
+  destination has been learnt on the other port is moved as it is onto the
+  TX ring of that port; everything else goes up to the stack (i.e. to the
+  bridge), which also takes care of flooding.
+*******************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/etherdevice.h>
+#include <linux/hash.h>
+#include <linux/seqlock.h>
+#include <linux/rcupdate.h>
+#include <linux/netdevice.h>
+#include <asm/unaligned.h>
+#include "stmmac.h"
+
+#define STMMAC_FWD_HASH_BITS	8
+#define STMMAC_FWD_HASH_SIZE	(1 << STMMAC_FWD_HASH_BITS)
+/* Same default as the bridge */
+#define STMMAC_FWD_AGEING	(300 * HZ)
+
+/* Direct mapped table: a new station simply replaces the one it collides
+ * with, the evicted one falls back to the stack until it is learnt again */
+struct stmmac_fwd_entry {
+	u8 addr[ETH_ALEN];
+	u16 vid;
+	u8 port;
+	u8 valid;
+	unsigned long stamp;
+};
+
+static struct stmmac_fwd_entry stmmac_fwd_table[STMMAC_FWD_HASH_SIZE];
+static DEFINE_SEQLOCK(stmmac_fwd_lock);
+static struct stmmac_priv __rcu *stmmac_fwd_ports[STMMAC_FWD_PORTS];
+
+static inline struct stmmac_fwd_entry *stmmac_fwd_entry(const u8 *addr,
+							 u16 vid)
+{
+	u32 key = get_unaligned((u32 *)(addr + 2)) ^ (addr[1] << 16) ^ vid;
+
+	return &stmmac_fwd_table[hash_32(key, STMMAC_FWD_HASH_BITS)];
+}
+
+/* platform id -1 is the only controller of the old boards, i.e. ETH0 */
+int stmmac_fwd_port(struct stmmac_priv *priv)
+{
+	return (priv->platform_id == 1) ? 1 : 0;
+}
+
+void stmmac_fwd_register(struct stmmac_priv *priv)
+{
+	rcu_assign_pointer(stmmac_fwd_ports[stmmac_fwd_port(priv)], priv);
+}
+
+void stmmac_fwd_unregister(struct stmmac_priv *priv)
+{
+	RCU_INIT_POINTER(stmmac_fwd_ports[stmmac_fwd_port(priv)], NULL);
+	synchronize_net();
+	stmmac_fwd_flush(stmmac_fwd_port(priv));
+}
+
+/* Called from the RX NAPI, i.e. within an RCU read side section */
+struct stmmac_priv *stmmac_fwd_peer(struct stmmac_priv *priv)
+{
+	return rcu_dereference(stmmac_fwd_ports[!stmmac_fwd_port(priv)]);
+}
+
+/**
+ * stmmac_fwd_learn - record the port a station has been seen on
+ * @port: receiving port
+ * @addr: source MAC address
+ * @vid: VLAN id, 0 for untagged frames
+ * Description: most of the frames come from a station already known on
+ * the same port, so the entry is rewritten only when it changes or once a
+ * second to keep it from ageing.
+ */
+void stmmac_fwd_learn(int port, const u8 *addr, u16 vid)
+{
+	struct stmmac_fwd_entry *e = stmmac_fwd_entry(addr, vid);
+
+	if (unlikely(!is_valid_ether_addr(addr)))
+		return;
+
+	if (e->valid && (e->port == port) && (e->vid == vid) &&
+	    ether_addr_equal(e->addr, addr) &&
+	    time_before(jiffies, e->stamp + HZ))
+		return;
+
+	write_seqlock(&stmmac_fwd_lock);
+	ether_addr_copy(e->addr, addr);
+	e->vid = vid;
+	e->port = port;
+	e->stamp = jiffies;
+	e->valid = 1;
+	write_sequnlock(&stmmac_fwd_lock);
+}
+
+/**
+ * stmmac_fwd_lookup - find the port of a destination
+ * @addr: destination MAC address
+ * @vid: VLAN id, 0 for untagged frames
+ * Return value: the port the station has been learnt on, -1 if unknown.
+ */
+int stmmac_fwd_lookup(const u8 *addr, u16 vid)
+{
+	struct stmmac_fwd_entry *e = stmmac_fwd_entry(addr, vid);
+	unsigned int seq;
+	int port;
+
+	do {
+		seq = read_seqbegin(&stmmac_fwd_lock);
+		port = -1;
+		if (e->valid && (e->vid == vid) &&
+		    ether_addr_equal(e->addr, addr) &&
+		    time_before(jiffies, e->stamp + STMMAC_FWD_AGEING))
+			port = e->port;
+	} while (read_seqretry(&stmmac_fwd_lock, seq));
+
+	return port;
+}
+
+/* Forget the stations of a port that goes down or stops forwarding */
+void stmmac_fwd_flush(int port)
+{
+	int i;
+
+	write_seqlock_bh(&stmmac_fwd_lock);
+	for (i = 0; i < STMMAC_FWD_HASH_SIZE; i++)
+		if (stmmac_fwd_table[i].port == port)
+			stmmac_fwd_table[i].valid = 0;
+	write_sequnlock_bh(&stmmac_fwd_lock);
+}
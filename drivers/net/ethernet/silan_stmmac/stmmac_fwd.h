@@ -0,0 +1,38 @@
+/*******************************************************************************
+  Silan GMAC: forwarding between ETH0 and ETH1 inside the driver
+
+  Copyright (C) 2013 Silan Microelectronics Ltd
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms and conditions of the GNU General Public License,
+  version 2, as published by the Free Software Foundation.
+
+  This program is distributed in the hope it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU General Public License along with
+  this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+
+  The full GNU General Public License is included in this distribution in
+  the file called "COPYING".
+*******************************************************************************/
+#ifndef __STMMAC_FWD_H__
+#define __STMMAC_FWD_H__
+
+/* ETH0 and ETH1 */
+#define STMMAC_FWD_PORTS	2
+
+struct stmmac_priv;
+
+extern void stmmac_fwd_register(struct stmmac_priv *priv);
+extern void stmmac_fwd_unregister(struct stmmac_priv *priv);
+extern struct stmmac_priv *stmmac_fwd_peer(struct stmmac_priv *priv);
+extern int stmmac_fwd_port(struct stmmac_priv *priv);
+extern void stmmac_fwd_learn(int port, const u8 *addr, u16 vid);
+extern int stmmac_fwd_lookup(const u8 *addr, u16 vid);
+extern void stmmac_fwd_flush(int port);
+
+#endif /* __STMMAC_FWD_H__ */
@@ -0,0 +1,106 @@
+/*******************************************************************************
+  Silan GMAC: NAPI poll histograms
+
+  Copyright (C) 2013 Silan Microelectronics Ltd
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms and conditions of the GNU General Public License,
+  version 2, as published by the Free Software Foundation.
+
+  This program is distributed in the hope it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU General Public License along with
+  this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+
+  The full GNU General Public License is included in this distribution in
+  the file called "COPYING".
+
+  The NAPI polls fill the histograms all the time, a few increments per
+  poll. They are shown in /sys/kernel/debug/stmmac/ethX/ while the
+  interface is up: a netdev can only be renamed when it is down.
+*******************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/netdevice.h>
+#include "stmmac.h"
+
+static struct dentry *stmmac_hist_root;
+
+/* One line per bucket up to the last used one: from, to, count */
+static int stmmac_hist_show(struct seq_file *seq, void *v)
+{
+	const struct stmmac_hist *h = seq->private;
+	int i, last = 0;
+
+	for (i = 0; i < STMMAC_HIST_BUCKETS; i++)
+		if (READ_ONCE(h->bucket[i]))
+			last = i;
+
+	for (i = 0; i <= last; i++) {
+		unsigned long n = READ_ONCE(h->bucket[i]);
+
+		if (i == 0)
+			seq_printf(seq, "%10u %10u %lu\n", 0, 0, n);
+		else if (i < STMMAC_HIST_BUCKETS - 1)
+			seq_printf(seq, "%10lu %10lu %lu\n", 1UL << (i - 1),
+				   (1UL << i) - 1, n);
+		else
+			seq_printf(seq, "%10lu %10s %lu\n", 1UL << (i - 1),
+				   "-", n);
+	}
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(stmmac_hist);
+
+void stmmac_hist_debugfs_init(void)
+{
+	stmmac_hist_root = debugfs_create_dir("stmmac", NULL);
+}
+
+void stmmac_hist_debugfs_exit(void)
+{
+	debugfs_remove_recursive(stmmac_hist_root);
+}
+
+/**
+ * stmmac_hist_register - show the histograms of an interface
+ * @priv: driver private structure
+ * Description: called at open. The histograms themselves are not cleared:
+ * like the other counters they cover the whole life of the device.
+ */
+void stmmac_hist_register(struct stmmac_priv *priv)
+{
+	struct stmmac_poll_hist *h = &priv->hist;
+	struct dentry *d;
+
+	d = debugfs_create_dir(priv->dev->name, stmmac_hist_root);
+	debugfs_create_file("rx_irq_delay_ns", 0444, d, &h->rx_delay,
+			    &stmmac_hist_fops);
+	debugfs_create_file("rx_work", 0444, d, &h->rx_work,
+			    &stmmac_hist_fops);
+	debugfs_create_ulong("rx_budget_exhausted", 0444, d,
+			     &h->rx_budget_n);
+	debugfs_create_file("rx_ring_ready", 0444, d, &h->rx_ring,
+			    &stmmac_hist_fops);
+	debugfs_create_file("rx_refill_short", 0444, d, &h->rx_short,
+			    &stmmac_hist_fops);
+	debugfs_create_file("tx_irq_delay_ns", 0444, d, &h->tx_delay,
+			    &stmmac_hist_fops);
+	debugfs_create_file("tx_batch", 0444, d, &h->tx_batch,
+			    &stmmac_hist_fops);
+	debugfs_create_ulong("tx_budget_exhausted", 0444, d,
+			     &h->tx_budget_n);
+	priv->hist_dir = d;
+}
+
+void stmmac_hist_unregister(struct stmmac_priv *priv)
+{
+	debugfs_remove_recursive(priv->hist_dir);
+	priv->hist_dir = NULL;
+}
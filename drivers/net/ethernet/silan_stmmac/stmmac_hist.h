@@ -0,0 +1,76 @@
+/*******************************************************************************
+  Silan GMAC: NAPI poll histograms
+
+  Copyright (C) 2013 Silan Microelectronics Ltd
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms and conditions of the GNU General Public License,
+  version 2, as published by the Free Software Foundation.
+
+  This program is distributed in the hope it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU General Public License along with
+  this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+
+  The full GNU General Public License is included in this distribution in
+  the file called "COPYING".
+*******************************************************************************/
+
+#ifndef __STMMAC_HIST_H__
+#define __STMMAC_HIST_H__
+
+#include <linux/bitops.h>
+#include <linux/cache.h>
+
+/* Power of two buckets: bucket 0 counts the zeros, bucket n the values in
+ * [2^(n-1), 2^n) and the last one everything above. 28 buckets reach 67ms
+ * for the delays, in ns. */
+#define STMMAC_HIST_BUCKETS	28
+
+struct stmmac_hist {
+	unsigned long bucket[STMMAC_HIST_BUCKETS];
+};
+
+/* Each half is written by its own NAPI only; the stamps are taken when the
+ * NAPI is scheduled, on the same CPU */
+struct stmmac_poll_hist {
+	u64 rx_stamp;
+	struct stmmac_hist rx_delay;	/* IRQ to poll, ns */
+	struct stmmac_hist rx_work;	/* work_done of each poll */
+	struct stmmac_hist rx_ring;	/* descriptors ready at poll start */
+	struct stmmac_hist rx_short;	/* descriptors left without buffer */
+	unsigned long rx_budget_n;	/* polls that used the whole budget */
+
+	u64 tx_stamp ____cacheline_aligned;
+	struct stmmac_hist tx_delay;	/* IRQ to poll, ns */
+	struct stmmac_hist tx_batch;	/* descriptors released per poll */
+	unsigned long tx_budget_n;
+};
+
+static inline void stmmac_hist_add(struct stmmac_hist *h, u64 v)
+{
+	unsigned int n = fls64(v);
+
+	if (unlikely(n >= STMMAC_HIST_BUCKETS))
+		n = STMMAC_HIST_BUCKETS - 1;
+	h->bucket[n]++;
+}
+
+struct stmmac_priv;
+#ifdef CONFIG_SILAN_GMAC_POLL_HIST
+extern void stmmac_hist_debugfs_init(void);
+extern void stmmac_hist_debugfs_exit(void);
+extern void stmmac_hist_register(struct stmmac_priv *priv);
+extern void stmmac_hist_unregister(struct stmmac_priv *priv);
+#else
+static inline void stmmac_hist_debugfs_init(void) {}
+static inline void stmmac_hist_debugfs_exit(void) {}
+static inline void stmmac_hist_register(struct stmmac_priv *priv) {}
+static inline void stmmac_hist_unregister(struct stmmac_priv *priv) {}
+#endif
+
+#endif /* __STMMAC_HIST_H__ */
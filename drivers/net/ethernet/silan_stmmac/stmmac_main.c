@@ -47,13 +47,18 @@
 #include <linux/dma-mapping.h>
 #include <linux/slab.h>
 #include <linux/prefetch.h>
+#include <linux/log2.h>
+#include <linux/rtnetlink.h>
+#include <linux/bpf_trace.h>
+#include <linux/sched/clock.h>
+#include <net/tso.h>
 #include <silan_regs.h>
 #include <silan_resources.h>
 #include <silan_setup.h>
 #include "stmmac.h"
-#ifdef CONFIG_SILAN_GMAC_TX_POSTCHK
-#include "silan_gmac_enhance.h"
-#endif
+#include "dwmac_dma.h"
+#define CREATE_TRACE_POINTS
+#include "stmmac_trace.h"
 
 #define REST_PHY_WHEN_100M_TO_1000M
 
@@ -76,6 +81,9 @@
  * The speed of our GMAC is 100Mbps, a value smaller than the original 64
  * will be better */
 #define GMAC_NAPI_WEIGHT    32
+/* The TX reclaim has its own NAPI; releasing a descriptor is cheap so it
+ * can take a bigger budget than the reception */
+#define GMAC_TX_NAPI_WEIGHT 64
 
 #undef STMMAC_DEBUG
 /*#define STMMAC_DEBUG*/
@@ -106,6 +114,46 @@
 #define STMMAC_ALIGN(x)	L1_CACHE_ALIGN(x)
 #define JUMBO_LEN	9000
 
+/* RX buffers are page_pool fragments that stay DMA mapped for their whole
+ * lifetime. In front of the frame there is the usual skb headroom and after
+ * it the room for the skb_shared_info, so build_skb() can wrap the buffer in
+ * place once the frame is complete. With the default 1536 bytes buffer two
+ * of them share a 4KiB page. An XDP program needs a bigger headroom, then
+ * each buffer takes a page on its own. */
+#ifdef CONFIG_SILAN_GMAC_FWD
+/* A forwarded frame carries its xdp_frame in the headroom */
+#define STMMAC_RX_HEADROOM	(max_t(unsigned int, NET_SKB_PAD, \
+				       L1_CACHE_ALIGN(sizeof(struct xdp_frame))) + \
+				 NET_IP_ALIGN)
+#else
+#define STMMAC_RX_HEADROOM	(NET_SKB_PAD + NET_IP_ALIGN)
+#endif
+#define STMMAC_XDP_HEADROOM	(XDP_PACKET_HEADROOM + NET_IP_ALIGN)
+#define STMMAC_RX_TRUESIZE(headroom, bfsize) \
+	(SKB_DATA_ALIGN((headroom) + (bfsize)) + \
+	 SKB_DATA_ALIGN(sizeof(struct skb_shared_info)))
+
+/* XDP verdicts as seen by the RX loop */
+#define STMMAC_XDP_PASS		0
+#define STMMAC_XDP_CONSUMED	(1 << 0)
+#define STMMAC_XDP_TX		(1 << 1)
+#define STMMAC_XDP_REDIRECT	(1 << 2)
+
+/* Frames shorter than this are copied into a small skb and their buffer
+ * is given back to the DMA (ethtool --set-tunable rx-copybreak) */
+#define STMMAC_RX_COPYBREAK	256
+/* Frames up to this size are copied into the coherent TX slot of their
+ * descriptor instead of being mapped (ethtool --set-tunable tx-copybreak) */
+#define STMMAC_TX_COPYBREAK	128
+
+/* Interrupt coalescing defaults (ethtool -C). On TX the interrupt on
+ * completion is requested once every STMMAC_TX_FRAMES frames, the others
+ * are reclaimed by the next interrupt or by the TX timer. On RX the
+ * watchdog is off, so every frame still raises its own interrupt. */
+#define STMMAC_TX_FRAMES	16
+#define STMMAC_COAL_TX_TIMER	1000	/* usec */
+#define STMMAC_RX_FRAMES	16
+
 /* Module parameters */
 #define TX_TIMEO 5000 /* default 5 seconds */
 static int watchdog = TX_TIMEO;
@@ -150,7 +198,7 @@ MODULE_PARM_DESC(tc, "DMA threshold control value");
 #define DEFAULT_PERIODIC_RATE	256
 static int tmrate = DEFAULT_PERIODIC_RATE;
 module_param(tmrate, int, S_IRUGO | S_IWUSR);
-MODULE_PARM_DESC(tmrate, "External timer freq. (default: 256Hz)");
+MODULE_PARM_DESC(tmrate, "Default external timer freq. (default: 256Hz)");
 #endif
 
 #define DMA_BUFFER_SIZE	BUF_SIZE_2KiB
@@ -175,6 +223,55 @@ static int desc_in_sram(int id)
 #endif
 	return 0; 
 }
+/* RX descriptors sharing a cache line */
+#define STMMAC_RX_DESC_PER_LINE	(L1_CACHE_BYTES / sizeof(struct dma_desc))
+
+/* RX ring in cacheable memory (CONFIG_SILAN_GMAC_RX_DESC_CACHED) */
+static inline bool stmmac_rx_desc_cached(struct stmmac_priv *priv)
+{
+#ifdef CONFIG_SILAN_GMAC_RX_DESC_CACHED
+	return !desc_in_sram(priv->platform_id);
+#else
+	return false;
+#endif
+}
+
+/**
+ * stmmac_rx_desc_sync_line - read again the line of an RX descriptor
+ * @priv: private driver structure
+ * @entry: index of the RX descriptor
+ * Description: in cacheable mode the line holding the descriptor is
+ * invalidated, the other descriptors of the line are then read from the
+ * cache. It is handed to the device first: on some architectures syncing
+ * for the CPU alone does not invalidate anything, and the line is never
+ * dirty here (see stmmac_rx_refill).
+ */
+static inline void stmmac_rx_desc_sync_line(struct stmmac_priv *priv,
+					    unsigned int entry)
+{
+	unsigned long offset;
+
+	if (!stmmac_rx_desc_cached(priv))
+		return;
+
+	offset = rounddown(entry, STMMAC_RX_DESC_PER_LINE) *
+		 sizeof(struct dma_desc);
+	dma_sync_single_range_for_device(priv->device, priv->dma_rx_phy,
+					 offset, L1_CACHE_BYTES,
+					 DMA_BIDIRECTIONAL);
+	dma_sync_single_range_for_cpu(priv->device, priv->dma_rx_phy,
+				      offset, L1_CACHE_BYTES,
+				      DMA_BIDIRECTIONAL);
+}
+
+/* The RX poll moves on to the descriptor @entry */
+static inline void stmmac_rx_desc_next(struct stmmac_priv *priv,
+				       unsigned int entry)
+{
+	if (!(entry % STMMAC_RX_DESC_PER_LINE))
+		stmmac_rx_desc_sync_line(priv, entry);
+}
+
 /**
  * stmmac_verify_args - verify the driver parameters.
  * Description: it verifies if some wrong parameter is passed to the driver.
@@ -188,6 +285,11 @@ static void stmmac_verify_args(void)
 		dma_rxsize = DMA_RX_SIZE;
 	if (unlikely(dma_txsize < 0))
 		dma_txsize = DMA_TX_SIZE;
+	/* The ring indexes are masked, not divided */
+	dma_rxsize = roundup_pow_of_two(clamp(dma_rxsize, STMMAC_MIN_RING_SIZE,
+					      STMMAC_MAX_RING_SIZE));
+	dma_txsize = roundup_pow_of_two(clamp(dma_txsize, STMMAC_MIN_RING_SIZE,
+					      STMMAC_MAX_RING_SIZE));
 	if (unlikely((buf_sz < DMA_BUFFER_SIZE) || (buf_sz > BUF_SIZE_16KiB)))
 		buf_sz = DMA_BUFFER_SIZE;
 	if (unlikely(flow_ctrl > 1))
@@ -196,6 +298,11 @@ static void stmmac_verify_args(void)
 		flow_ctrl = FLOW_OFF;
 	if (unlikely((pause < 0) || (pause > 0xffff)))
 		pause = PAUSE_TIME;
+#ifdef CONFIG_STMMAC_TIMER
+	/* ethtool reports the period, USEC_PER_SEC / tmrate */
+	if (unlikely((tmrate <= 0) || (tmrate > USEC_PER_SEC)))
+		tmrate = DEFAULT_PERIODIC_RATE;
+#endif
 }
 
 #if defined(STMMAC_XMIT_DEBUG) || defined(STMMAC_RX_DEBUG)
@@ -212,12 +319,52 @@ static void print_pkt(unsigned char *buf, int len)
 }
 #endif
 
+/* The longest chain queued by a transmit path: a fragmented skb, or a
+ * software TSO skb (bounded by stmmac_features_check) */
+#define STMMAC_TX_MAX_DESCS(x)	max_t(unsigned int, MAX_SKB_FRAGS + 1, \
+				      (x)->dma_tx_size / 4)
+
 /* minimum number of free TX descriptors required to wake up TX process */
-#define STMMAC_TX_THRESH(x)	(x->dma_tx_size/4)
+#define STMMAC_TX_THRESH(x)	(STMMAC_TX_MAX_DESCS(x) + (x)->dma_tx_size / 8)
+
+/* The ring sizes are powers of two: the free running indexes are masked */
+#define STMMAC_TX_ENTRY(x, i)	((i) & ((x)->dma_tx_size - 1))
+#define STMMAC_RX_ENTRY(x, i)	((i) & ((x)->dma_rx_size - 1))
 
+/* The TX ring is a single producer/single consumer ring. The transmit
+ * paths (under the TX queue lock) fill the descriptors and the shadow
+ * entries of a frame, then publish cur_tx with a release; stmmac_tx reads
+ * it with an acquire, cleans the entries and publishes dirty_tx the same
+ * way, so neither side ever sees an entry the other is still writing. */
 static inline u32 stmmac_tx_avail(struct stmmac_priv *priv)
 {
-	return priv->dirty_tx + priv->dma_tx_size - priv->cur_tx - 1;
+	return smp_load_acquire(&priv->dirty_tx) + priv->dma_tx_size -
+	       READ_ONCE(priv->cur_tx) - 1;
+}
+
+static inline void stmmac_tx_publish(struct stmmac_priv *priv,
+				     unsigned int cur)
+{
+	smp_store_release(&priv->cur_tx, cur);
+}
+
+/* Stop the queue, then look again: the completion may have freed the
+ * ring before seeing it stopped. Pairs with the smp_mb() in stmmac_tx. */
+static void stmmac_tx_stop(struct stmmac_priv *priv)
+{
+	netif_stop_queue(priv->dev);
+	smp_mb();
+	if (stmmac_tx_avail(priv) > STMMAC_TX_THRESH(priv))
+		netif_start_queue(priv->dev);
+}
+
+/* Keep room for the longest chain while the queue is awake */
+static inline void stmmac_tx_maybe_stop(struct stmmac_priv *priv)
+{
+	if (unlikely(stmmac_tx_avail(priv) <= STMMAC_TX_MAX_DESCS(priv))) {
+		TX_DBG("%s: stop transmitted packets\n", __func__);
+		stmmac_tx_stop(priv);
+	}
 }
 
 /* On some ST platforms, some HW system configuraton registers have to be
@@ -258,7 +405,7 @@ static void stmmac_adjust_link(struct net_device *dev)
 		return;
 
 	DBG(probe, DEBUG, "stmmac_adjust_link: called.  address %d link %d\n",
-	    phydev->addr, phydev->link);
+	    phydev->mdio.addr, phydev->link);
 
 	spin_lock_irqsave(&priv->lock, flags);
 	if (phydev->link) {
@@ -316,7 +463,7 @@ static void stmmac_adjust_link(struct net_device *dev)
 				break;
 			default:
 				if (netif_msg_link(priv))
-					pr_warning("%s: Speed (%d) is not 10"
+					pr_warn("%s: Speed (%d) is not 10"
 				       " or 100!\n", dev->name, phydev->speed);
 				break;
 			}
@@ -373,8 +520,8 @@ static int stmmac_init_phy(struct net_device *dev)
 		 priv->phy_addr);
 	pr_debug("stmmac_init_phy:  trying to attach to %s\n", phy_id);
 
-	phydev = phy_connect(dev, phy_id, &stmmac_adjust_link, 0,
-			priv->phy_interface);
+	phydev = phy_connect(dev, phy_id, &stmmac_adjust_link,
+			     priv->phy_interface);
 
 	if (IS_ERR(phydev)) {
 		pr_err("%s: Could not attach to PHY\n", dev->name);
@@ -440,51 +587,351 @@ static void display_ring(struct dma_desc *p, int size)
 	}
 }
 
+/**
+ * stmmac_set_bfsize - select the RX buffer size
+ * @mtu: the MTU of the device
+ * Description: the buffer has to hold a whole frame (VLAN tag and FCS
+ * included); in case of jumbo we need to bump-up the buffer sizes.
+ * Only XDP needs this, the normal path scatters jumbo frames.
+ */
+static int stmmac_set_bfsize(int mtu)
+{
+	int bfsize;
+
+	if (unlikely(mtu >= BUF_SIZE_8KiB))
+		bfsize = BUF_SIZE_16KiB;
+	else if (unlikely(mtu >= BUF_SIZE_4KiB))
+		bfsize = BUF_SIZE_8KiB;
+	else if (unlikely(mtu >= BUF_SIZE_2KiB))
+		bfsize = BUF_SIZE_4KiB;
+	else if (unlikely(mtu > ETH_DATA_LEN))
+		bfsize = BUF_SIZE_2KiB;
+	else
+		bfsize = BUF_SIZE_1_5KiB;
+
+	return bfsize;
+}
+
+/* Buffer size of a scattered frame. The normal descriptors hold at most
+ * 2KiB - 1 bytes and the size stays a multiple of the widest data bus (16
+ * bytes): the DMA fills each buffer but the last one exactly */
+#define STMMAC_RX_SCATTER_SZ	ALIGN_DOWN(BUF_SIZE_2KiB - 1, 16)
+
+/* Size of the buffer behind each RX descriptor for a given MTU */
+static unsigned int stmmac_rx_buf_size(struct stmmac_priv *priv, int mtu)
+{
+	unsigned int bfsize = stmmac_set_bfsize(mtu);
+
+	/* The DMA must not write past the UMEM frame */
+	if (priv->xsk_pool)
+		bfsize = min_t(unsigned int, bfsize,
+			       ALIGN_DOWN(xsk_pool_get_rx_frame_size(priv->xsk_pool),
+					  8));
+
+	/* Without XDP a jumbo frame is received over several 2KiB buffers
+	 * (see stmmac_rx_scatter) instead of one huge buffer per descriptor */
+	if (!priv->xdp_prog && !priv->xsk_pool)
+		bfsize = min_t(unsigned int, bfsize, STMMAC_RX_SCATTER_SZ);
+
+	return bfsize;
+}
+
+/* The XDP buffer, headroom and skb_shared_info included, has to fit in a
+ * page */
+static inline bool stmmac_xdp_mtu_ok(int mtu)
+{
+	return STMMAC_RX_TRUESIZE(STMMAC_XDP_HEADROOM,
+				  stmmac_set_bfsize(mtu)) <= PAGE_SIZE;
+}
+
+/* In zero-copy mode a frame, VLAN tag and FCS included, has to fit in the
+ * RX buffer carved out of a single UMEM frame (see stmmac_rx_buf_size) */
+static inline bool stmmac_xsk_mtu_ok(struct xsk_buff_pool *pool, int mtu)
+{
+	return mtu + ETH_HLEN + VLAN_HLEN + ETH_FCS_LEN <=
+	       ALIGN_DOWN(xsk_pool_get_rx_frame_size(pool), 8);
+}
+
+/**
+ * stmmac_alloc_page_pool - create the page pool feeding the RX ring
+ * @priv: private driver structure
+ * Description: the pool maps its pages once, when they are allocated, and
+ * keeps them mapped while they are recycled.
+ */
+static int stmmac_alloc_page_pool(struct stmmac_priv *priv)
+{
+	struct page_pool_params pp_params = { 0 };
+	int ret;
+
+	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_PAGE_FRAG;
+	pp_params.order = get_order(priv->rx_truesize);
+	pp_params.pool_size = priv->dma_rx_size;
+	pp_params.nid = dev_to_node(priv->device);
+	pp_params.dev = priv->device;
+	pp_params.dma_dir = priv->rx_dma_dir;
+
+	priv->page_pool = page_pool_create(&pp_params);
+	if (IS_ERR(priv->page_pool)) {
+		ret = PTR_ERR(priv->page_pool);
+		priv->page_pool = NULL;
+		return ret;
+	}
+	return 0;
+}
+
+/**
+ * stmmac_alloc_rx_buffer - attach a new RX buffer to a descriptor
+ * @priv: private driver structure
+ * @entry: index of the RX descriptor
+ * @gfp: allocation flags
+ * Description: it takes a fragment from the page pool and hands it to the
+ * DMA. The page is already mapped so only the cache has to be synced.
+ * In zero-copy mode the buffer is a UMEM frame from the AF_XDP fill ring.
+ */
+static int stmmac_alloc_rx_buffer(struct stmmac_priv *priv,
+				  unsigned int entry, gfp_t gfp)
+{
+	struct stmmac_rx_buffer *buf = priv->rx_buf + entry;
+	struct dma_desc *p = priv->dma_rx + entry;
+	unsigned int offset;
+	struct page *page;
+
+	if (priv->xsk_pool) {
+		buf->xdp = xsk_buff_alloc(priv->xsk_pool);
+		if (unlikely(buf->xdp == NULL))
+			return -ENOMEM;
+		buf->dma = xsk_buff_xdp_get_dma(buf->xdp);
+		p->des2 = buf->dma;
+		return 0;
+	}
+
+	page = page_pool_alloc_frag(priv->page_pool, &offset,
+				    priv->rx_truesize, gfp);
+	if (unlikely(page == NULL))
+		return -ENOMEM;
+
+	buf->page = page;
+	buf->page_offset = offset;
+	buf->dma = page_pool_get_dma_addr(page) + offset + priv->rx_headroom;
+	dma_sync_single_for_device(priv->device, buf->dma,
+				   priv->dma_buf_sz, priv->rx_dma_dir);
+
+	p->des2 = buf->dma;
+	/* If the MTU exceeds 8k so use the second buffer in the chain */
+	if (unlikely(priv->dma_buf_sz >= BUF_SIZE_8KiB))
+		p->des3 = buf->dma + BUF_SIZE_8KiB;
+
+	return 0;
+}
+
+/**
+ * stmmac_rx_ic - tell whether an RX descriptor interrupts on completion
+ * @priv: private driver structure
+ * @entry: index of the RX descriptor
+ * Description: when the RX watchdog is armed only one descriptor every
+ * rx_coal_frames raises the interrupt, the watchdog takes care of the
+ * others. Without the watchdog every frame interrupts, unless the external
+ * timer drives the reception.
+ */
+static inline int stmmac_rx_ic(struct stmmac_priv *priv, unsigned int entry)
+{
+#ifdef CONFIG_STMMAC_TIMER
+	if (likely(priv->tm->enable))
+		return 0;
+#endif
+	if (!priv->rx_riwt)
+		return 1;
+	return priv->rx_coal_frames && !((entry + 1) % priv->rx_coal_frames);
+}
+
+/**
+ * stmmac_rx_coalesce_write - program the RX interrupt coalescing
+ * @priv: private driver structure
+ * Description: it writes the RX watchdog and updates the interrupt on
+ * completion bit of the whole ring. The DMA never writes RDES1 back but
+ * stmmac_rx_refill does, so this runs either with the NAPI stopped or
+ * from the NAPI poll itself.
+ */
+static void stmmac_rx_coalesce_write(struct stmmac_priv *priv)
+{
+	int i;
+
+	if (priv->hw->dma->rx_watchdog)
+		priv->hw->dma->rx_watchdog(priv->ioaddr, priv->rx_riwt);
+
+	/* A cached line must not be written while the DMA owns some of its
+	 * descriptors: stmmac_rx_refill sets the bit as the ring turns */
+	if (stmmac_rx_desc_cached(priv))
+		return;
+
+	for (i = 0; i < priv->dma_rx_size; i++)
+		priv->hw->desc->set_rx_ic(priv->dma_rx + i,
+					  stmmac_rx_ic(priv, i));
+}
+
+/* The RX watchdog counts in units of 256 GMAC clock cycles */
+u32 stmmac_usec2riwt(struct stmmac_priv *priv, u32 usec)
+{
+	unsigned long clk = clk_get_rate(priv->clk) / 1000000;
+
+	return min_t(u64, DIV_ROUND_UP_ULL((u64)usec * clk, 256), U32_MAX);
+}
+
+u32 stmmac_riwt2usec(struct stmmac_priv *priv, u32 riwt)
+{
+	unsigned long clk = clk_get_rate(priv->clk) / 1000000;
+
+	return (riwt * 256) / clk;
+}
+
+/**
+ * stmmac_rx_dim_work - apply the RX moderation chosen by DIM
+ * @work: work embedded in the rx_dim structure
+ * Description: the profile gives the RX watchdog (usec) and how many
+ * descriptors share an interrupt (pkts).
+ */
+static void stmmac_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_priv *priv = container_of(dim, struct stmmac_priv,
+						rx_dim);
+	struct dim_cq_moder moder;
+
+	moder = net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+	priv->rx_riwt = min_t(u32, stmmac_usec2riwt(priv, moder.usec),
+			      STMMAC_MAX_DMA_RIWT);
+	priv->rx_coal_frames = min_t(u32, moder.pkts, priv->dma_rx_size);
+	stmmac_rx_coalesce_apply(priv);
+
+	priv->xstats.rx_dim_profile = dim->profile_ix;
+	priv->xstats.rx_dim_transitions++;
+	dim->state = DIM_START_MEASURE;
+}
+
+/**
+ * stmmac_tx_dim_work - apply the TX moderation chosen by DIM
+ * @work: work embedded in the tx_dim structure
+ * Description: the profile gives how many frames share the interrupt on
+ * completion; the TX timer keeps reclaiming the tail of the bursts.
+ */
+static void stmmac_tx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_priv *priv = container_of(dim, struct stmmac_priv,
+						tx_dim);
+	struct dim_cq_moder moder;
+
+	moder = net_dim_get_tx_moderation(dim->mode, dim->profile_ix);
+	if (!priv->tx_coal_timer)
+		priv->tx_coal_timer = STMMAC_COAL_TX_TIMER;
+	priv->tx_coal_frames = clamp_t(u32, moder.pkts, 1,
+				       priv->dma_tx_size / 2);
+
+	priv->xstats.tx_dim_profile = dim->profile_ix;
+	priv->xstats.tx_dim_transitions++;
+	dim->state = DIM_START_MEASURE;
+}
+
+/**
+ * stmmac_dim_enable - turn the adaptive moderation on/off
+ * @priv: private driver structure
+ * @rx: adaptive RX moderation (it needs the RX watchdog)
+ * @tx: adaptive TX moderation
+ * Description: a decision still pending when DIM is turned off is dropped
+ * so it cannot overwrite the static values just programmed.
+ */
+void stmmac_dim_enable(struct stmmac_priv *priv, bool rx, bool tx)
+{
+	if (priv->rx_dim_enabled && !rx)
+		cancel_work_sync(&priv->rx_dim.work);
+	if (priv->tx_dim_enabled && !tx)
+		cancel_work_sync(&priv->tx_dim.work);
+
+	priv->rx_dim_enabled = rx && priv->hw->dma->rx_watchdog;
+	priv->tx_dim_enabled = tx;
+}
+
+/**
+ * stmmac_rx_dim_update - feed the RX DIM engine
+ * @priv: private driver structure
+ * Description: called at the end of each RX NAPI cycle; the number of polls
+ * is the event counter, packets and bytes are the ones seen so far.
+ */
+static inline void stmmac_rx_dim_update(struct stmmac_priv *priv)
+{
+	struct dim_sample sample;
+
+	/* Only the RX NAPI writes these counters */
+	if (priv->rx_dim_enabled) {
+		dim_update_sample(u64_stats_read(&priv->rx_stats.poll_n),
+				  u64_stats_read(&priv->rx_stats.pkt_n),
+				  u64_stats_read(&priv->rx_stats.bytes),
+				  &sample);
+		net_dim(&priv->rx_dim, sample);
+	}
+}
+
+/* Same as above for the TX NAPI */
+static inline void stmmac_tx_dim_update(struct stmmac_priv *priv)
+{
+	struct dim_sample sample;
+	unsigned int start;
+	u64 bytes;
+
+	if (priv->tx_dim_enabled) {
+		/* The bytes are counted by the transmit paths */
+		do {
+			start = u64_stats_fetch_begin(&priv->tx_stats.syncp);
+			bytes = u64_stats_read(&priv->tx_stats.bytes);
+		} while (u64_stats_fetch_retry(&priv->tx_stats.syncp, start));
+		dim_update_sample(u64_stats_read(&priv->txc_stats.poll_n),
+				  u64_stats_read(&priv->txc_stats.packets),
+				  bytes, &sample);
+		net_dim(&priv->tx_dim, sample);
+	}
+}
+
 /**
  * init_dma_desc_rings - init the RX/TX descriptor rings
  * @dev: net device structure
  * Description:  this function initializes the DMA RX/TX descriptors
- * and allocates the socket buffers.
+ * and fills the RX ring with buffers taken from the page pool.
  */
-static void init_dma_desc_rings(struct net_device *dev)
+static int init_dma_desc_rings(struct net_device *dev)
 {
-	int i, ii;
+	int i, ii, ret;
 	struct stmmac_priv *priv = netdev_priv(dev);
-	struct sk_buff *skb;
 	unsigned int txsize = priv->dma_tx_size;
 	unsigned int rxsize = priv->dma_rx_size;
-	unsigned int bfsize = priv->dma_buf_sz;
-	int buff2_needed = 0, dis_ic = 0;
+	unsigned int bfsize;
+	int dis_ic = 0;
 
-	/* Set the Buffer size according to the MTU;
-	 * indeed, in case of jumbo we need to bump-up the buffer sizes.
-	 */
-	if (unlikely(dev->mtu >= BUF_SIZE_8KiB))
-		bfsize = BUF_SIZE_16KiB;
-	else if (unlikely(dev->mtu >= BUF_SIZE_4KiB))
-		bfsize = BUF_SIZE_8KiB;
-	else if (unlikely(dev->mtu >= BUF_SIZE_2KiB))
-		bfsize = BUF_SIZE_4KiB;
-	else if (unlikely(dev->mtu >= DMA_BUFFER_SIZE))
-		bfsize = BUF_SIZE_2KiB;
-	else
-		bfsize = DMA_BUFFER_SIZE;
+	bfsize = stmmac_rx_buf_size(priv, dev->mtu);
 
 #ifdef CONFIG_STMMAC_TIMER
 	/* Disable interrupts on completion for the reception if timer is on */
 	if (likely(priv->tm->enable))
 		dis_ic = 1;
 #endif
-	/* If the MTU exceeds 8k so use the second buffer in the chain */
-	if (bfsize >= BUF_SIZE_8KiB)
-		buff2_needed = 1;
 
 	DBG(probe, INFO, "stmmac: txsize %d, rxsize %d, bfsize %d\n",
 	    txsize, rxsize, bfsize);
 
-	priv->rx_skbuff_dma = kmalloc(rxsize * sizeof(dma_addr_t), GFP_KERNEL);
-	priv->rx_skbuff =
-	    kmalloc(sizeof(struct sk_buff *) * rxsize, GFP_KERNEL);
+	priv->dma_buf_sz = bfsize;
+	/* XDP_TX sends the RX pages back as they are: they must be mapped
+	 * for both directions */
+	if (priv->xdp_prog) {
+		priv->rx_headroom = STMMAC_XDP_HEADROOM;
+		priv->rx_dma_dir = DMA_BIDIRECTIONAL;
+	} else {
+		priv->rx_headroom = STMMAC_RX_HEADROOM;
+		priv->rx_dma_dir = DMA_FROM_DEVICE;
+	}
+	priv->rx_truesize = STMMAC_RX_TRUESIZE(priv->rx_headroom, bfsize);
+	buf_sz = bfsize;
+
+	priv->rx_buf = kcalloc(rxsize, sizeof(struct stmmac_rx_buffer),
+			       GFP_KERNEL);
 	if (desc_in_sram(priv->platform_id)) {
 #ifdef SILAN_GMAC_SRAM_BASE
 		priv->dma_rx     = (struct dma_desc *)SILAN_GMAC_SRAM_BASE;
@@ -497,7 +944,16 @@ static void init_dma_desc_rings(struct net_device *dev)
 #endif
 	}
 	else {
-		priv->dma_rx =
+		if (stmmac_rx_desc_cached(priv)) {
+			priv->dma_rx = dma_alloc_noncoherent(priv->device,
+					rxsize * sizeof(struct dma_desc),
+					&priv->dma_rx_phy, DMA_BIDIRECTIONAL,
+					GFP_KERNEL);
+			if (priv->dma_rx)
+				memset(priv->dma_rx, 0,
+				       rxsize * sizeof(struct dma_desc));
+		} else
+			priv->dma_rx =
 			(struct dma_desc *)dma_alloc_coherent(priv->device,
 					rxsize *
 					sizeof(struct dma_desc),
@@ -510,13 +966,52 @@ static void init_dma_desc_rings(struct net_device *dev)
 					&priv->dma_tx_phy,
 					GFP_KERNEL);
 	}
-	priv->tx_skbuff = kmalloc(sizeof(struct sk_buff *) * txsize,
-				GFP_KERNEL);
+	priv->tx_buf = kcalloc(txsize, sizeof(struct stmmac_tx_buffer),
+			       GFP_KERNEL);
 
-	if ((priv->dma_rx == NULL) || (priv->dma_tx == NULL)) {
+	if ((priv->dma_rx == NULL) || (priv->dma_tx == NULL) ||
+	    (priv->rx_buf == NULL) || (priv->tx_buf == NULL)) {
 		pr_err("%s:ERROR allocating the DMA Tx/Rx desc\n", __func__);
-		return;
+		return -ENOMEM;
+	}
+
+	if (!priv->xsk_pool) {
+		ret = stmmac_alloc_page_pool(priv);
+		if (ret) {
+			pr_err("%s: ERROR creating the RX page pool\n",
+			       __func__);
+			return ret;
+		}
+	}
+
+	/* TSO headers and small frames are written there by the CPU and read
+	 * by the DMA without any mapping or cache maintenance */
+	BUILD_BUG_ON(TSO_HEADER_SIZE > STMMAC_TX_SLOT_SIZE);
+	priv->tx_slots = dma_alloc_coherent(priv->device,
+					    txsize * STMMAC_TX_SLOT_SIZE,
+					    &priv->tx_slots_phy, GFP_KERNEL);
+	if (priv->tx_slots == NULL) {
+		pr_err("%s: ERROR allocating the TX slots\n", __func__);
+		return -ENOMEM;
+	}
+
+	ret = xdp_rxq_info_reg(&priv->xdp_rxq, dev, 0, priv->napi.napi_id);
+	if (!ret) {
+		if (priv->xsk_pool)
+			ret = xdp_rxq_info_reg_mem_model(&priv->xdp_rxq,
+							 MEM_TYPE_XSK_BUFF_POOL,
+							 NULL);
+		else
+			ret = xdp_rxq_info_reg_mem_model(&priv->xdp_rxq,
+							 MEM_TYPE_PAGE_POOL,
+							 priv->page_pool);
 	}
+	if (ret) {
+		pr_err("%s: ERROR registering the XDP RX queue\n", __func__);
+		return ret;
+	}
+	if (priv->xsk_pool)
+		xsk_pool_set_rxq_info(priv->xsk_pool, &priv->xdp_rxq);
 
 	DBG(probe, INFO, "stmmac (%s) DMA desc rings: virt addr (Rx %p, "
 	    "Tx %p)\n\tDMA phy addr (Rx 0x%08x, Tx 0x%08x)\n",
@@ -524,35 +1019,31 @@ static void init_dma_desc_rings(struct net_device *dev)
 	    (unsigned int)priv->dma_rx_phy, (unsigned int)priv->dma_tx_phy);
 
 	/* RX INITIALIZATION */
-	DBG(probe, INFO, "stmmac: SKB addresses:\n"
-			 "skb\t\tskb data\tdma data\n");
+	DBG(probe, INFO, "stmmac: RX buffers:\n"
+			 "page\t\toffset\tdma data\n");
 
 	for (i = 0; i < rxsize; i++) {
-		struct dma_desc *p = priv->dma_rx + i;
-
-		skb = netdev_alloc_skb_ip_align(dev, bfsize);
-		if (unlikely(skb == NULL)) {
-			pr_err("%s: Rx init fails; skb is NULL\n", __func__);
+		if (stmmac_alloc_rx_buffer(priv, i, GFP_KERNEL)) {
+			/* The AF_XDP fill ring may well be empty yet */
+			if (!priv->xsk_pool)
+				pr_err("%s: Rx init fails; no page\n",
+				       __func__);
 			break;
 		}
-		priv->rx_skbuff[i] = skb;
-		priv->rx_skbuff_dma[i] = dma_map_single(priv->device, skb->data,
-						bfsize, DMA_FROM_DEVICE);
-
-		p->des2 = priv->rx_skbuff_dma[i];
-		if (unlikely(buff2_needed))
-			p->des3 = p->des2 + BUF_SIZE_8KiB;
-		DBG(probe, INFO, "[%p]\t[%p]\t[%x]\n", priv->rx_skbuff[i],
-			priv->rx_skbuff[i]->data, priv->rx_skbuff_dma[i]);
+		DBG(probe, INFO, "[%p]\t[%u]\t[%x]\n", priv->rx_buf[i].page,
+			priv->rx_buf[i].page_offset, priv->rx_buf[i].dma);
 	}
 	priv->cur_rx = 0;
+	/* The refill hands whole lines back to the DMA */
+	if (stmmac_rx_desc_cached(priv))
+		i = rounddown(i, STMMAC_RX_DESC_PER_LINE);
 	priv->dirty_rx = (unsigned int)(i - rxsize);
-	priv->dma_buf_sz = bfsize;
-	buf_sz = bfsize;
+	if (priv->xsk_pool && xsk_uses_need_wakeup(priv->xsk_pool))
+		xsk_set_rx_need_wakeup(priv->xsk_pool);
 
 	/* TX INITIALIZATION */
 	for (i = 0; i < txsize; i++) {
-		priv->tx_skbuff[i] = NULL;
+		memset(priv->tx_buf + i, 0, sizeof(struct stmmac_tx_buffer));
 		*((u32 *)&(priv->dma_tx[i].des01)) = 0;
 		*((u32 *)&(priv->dma_tx[i].des01) + 1) = 0;
 		priv->dma_tx[i].des2 = 0;
@@ -562,8 +1053,12 @@ static void init_dma_desc_rings(struct net_device *dev)
 	priv->cur_tx = 0;
 
 	/* Clear the Rx/Tx descriptors */
-	priv->hw->desc->init_rx_desc(priv->dma_rx, rxsize, dis_ic);
+	priv->hw->desc->init_rx_desc(priv->dma_rx, rxsize, dis_ic, bfsize);
 	priv->hw->desc->init_tx_desc(priv->dma_tx, txsize);
+	if (stmmac_rx_desc_cached(priv))
+		dma_sync_single_for_device(priv->device, priv->dma_rx_phy,
+					   rxsize * sizeof(struct dma_desc),
+					   DMA_BIDIRECTIONAL);
 
 	if (netif_msg_hw(priv)) {
 		pr_info("RX descriptor ring:\n");
@@ -571,58 +1066,124 @@ static void init_dma_desc_rings(struct net_device *dev)
 		pr_info("TX descriptor ring:\n");
 		display_ring(priv->dma_tx, txsize);
 	}
+
+	return 0;
 }
 
 static void dma_free_rx_skbufs(struct stmmac_priv *priv)
 {
 	int i;
 
+	/* Its pages belong to the pool: release them before it goes away */
+	if (priv->rx_skb) {
+		dev_kfree_skb_any(priv->rx_skb);
+		priv->rx_skb = NULL;
+	}
+	priv->rx_skb_drop = false;
+
+	if (priv->rx_buf == NULL)
+		return;
+
 	for (i = 0; i < priv->dma_rx_size; i++) {
-		if (priv->rx_skbuff[i]) {
-			dma_unmap_single(priv->device, priv->rx_skbuff_dma[i],
-					 priv->dma_buf_sz, DMA_FROM_DEVICE);
-			dev_kfree_skb_any(priv->rx_skbuff[i]);
-		}
-		priv->rx_skbuff[i] = NULL;
+		struct stmmac_rx_buffer *buf = priv->rx_buf + i;
+
+		if (buf->page)
+			page_pool_put_full_page(priv->page_pool, buf->page,
+						false);
+		if (buf->xdp)
+			xsk_buff_free(buf->xdp);
+		buf->page = NULL;
+		buf->xdp = NULL;
 	}
 }
 
+/* XDP_TX pages, UMEM frames and TX slots keep the mapping of their pool */
+static inline void stmmac_tx_unmap(struct stmmac_priv *priv,
+				   struct stmmac_tx_buffer *tx_buf)
+{
+	if (!tx_buf->dma)
+		return;
+	if (tx_buf->map_as_page)
+		dma_unmap_page(priv->device, tx_buf->dma, tx_buf->len,
+			       DMA_TO_DEVICE);
+	else
+		dma_unmap_single(priv->device, tx_buf->dma, tx_buf->len,
+				 DMA_TO_DEVICE);
+}
+
 static void dma_free_tx_skbufs(struct stmmac_priv *priv)
 {
+	unsigned int xsk_frames = 0;
 	int i;
 
+	if (priv->tx_buf == NULL)
+		return;
+
 	for (i = 0; i < priv->dma_tx_size; i++) {
-		if (priv->tx_skbuff[i] != NULL) {
-			struct dma_desc *p = priv->dma_tx + i;
-			if (p->des2)
-				dma_unmap_single(priv->device, p->des2,
-						 priv->hw->desc->get_tx_len(p),
-						 DMA_TO_DEVICE);
-			dev_kfree_skb_any(priv->tx_skbuff[i]);
-			priv->tx_skbuff[i] = NULL;
+		struct stmmac_tx_buffer *tx_buf = priv->tx_buf + i;
+
+		stmmac_tx_unmap(priv, tx_buf);
+		switch (tx_buf->type) {
+		case STMMAC_TXBUF_T_SKB:
+			if (tx_buf->skb)
+				dev_kfree_skb_any(tx_buf->skb);
+			break;
+		case STMMAC_TXBUF_T_XDP_TX:
+		case STMMAC_TXBUF_T_XDP_NDO:
+			xdp_return_frame(tx_buf->xdpf);
+			break;
+		case STMMAC_TXBUF_T_XSK_TX:
+			xsk_frames++;
+			break;
 		}
+		memset(tx_buf, 0, sizeof(*tx_buf));
 	}
+	if (xsk_frames)
+		xsk_tx_completed(priv->xsk_pool, xsk_frames);
 }
 
 static void free_dma_desc_resources(struct stmmac_priv *priv)
 {
-	if (!desc_in_sram(priv->platform_id)) {
-		/* Release the DMA TX/RX socket buffers */
-		dma_free_rx_skbufs(priv);
-		dma_free_tx_skbufs(priv);
+	/* Release the DMA TX/RX buffers */
+	dma_free_rx_skbufs(priv);
+	dma_free_tx_skbufs(priv);
 
+	if (!desc_in_sram(priv->platform_id)) {
 		/* Free the region of consistent memory previously allocated for
 		 * the DMA */
+		if (priv->dma_tx)
+			dma_free_coherent(priv->device,
+					priv->dma_tx_size * sizeof(struct dma_desc),
+					priv->dma_tx, priv->dma_tx_phy);
+		if (priv->dma_rx && stmmac_rx_desc_cached(priv))
+			dma_free_noncoherent(priv->device,
+					priv->dma_rx_size * sizeof(struct dma_desc),
+					priv->dma_rx, priv->dma_rx_phy,
+					DMA_BIDIRECTIONAL);
+		else if (priv->dma_rx)
+			dma_free_coherent(priv->device,
+					priv->dma_rx_size * sizeof(struct dma_desc),
+					priv->dma_rx, priv->dma_rx_phy);
+	}
+	priv->dma_tx = NULL;
+	priv->dma_rx = NULL;
+
+	if (priv->tx_slots) {
 		dma_free_coherent(priv->device,
-				priv->dma_tx_size * sizeof(struct dma_desc),
-				priv->dma_tx, priv->dma_tx_phy);
-		dma_free_coherent(priv->device,
-				priv->dma_rx_size * sizeof(struct dma_desc),
-				priv->dma_rx, priv->dma_rx_phy);
+				  priv->dma_tx_size * STMMAC_TX_SLOT_SIZE,
+				  priv->tx_slots, priv->tx_slots_phy);
+		priv->tx_slots = NULL;
+	}
+	if (xdp_rxq_info_is_reg(&priv->xdp_rxq))
+		xdp_rxq_info_unreg(&priv->xdp_rxq);
+	if (priv->page_pool) {
+		page_pool_destroy(priv->page_pool);
+		priv->page_pool = NULL;
 	}
-	kfree(priv->rx_skbuff_dma);
-	kfree(priv->rx_skbuff);
-	kfree(priv->tx_skbuff);
+	kfree(priv->rx_buf);
+	kfree(priv->tx_buf);
+	priv->rx_buf = NULL;
+	priv->tx_buf = NULL;
 }
 
 /**
@@ -647,126 +1208,389 @@ static void stmmac_dma_operation_mode(struct stmmac_priv *priv)
 		priv->hw->dma->dma_mode(priv->ioaddr, tc, SF_DMA_MODE);
 }
 
+/* The poll loops are built once per descriptor layout with @enh constant:
+ * the status word is loaded once (the ring is uncached) and decoded with
+ * masks, the hw->desc callbacks only run for the frames with something to
+ * account (errors, deferral, VLAN, multicast...). */
+static __always_inline u32 stmmac_desc_word(struct dma_desc *p, int n)
+{
+	return READ_ONCE(*((u32 *)p + n));
+}
+
+static __always_inline int stmmac_desc_tx_status(struct stmmac_priv *priv,
+						 struct dma_desc *p,
+						 u32 tdes0, const bool enh)
+{
+	u32 slow = TDES0_ES | TDES0_DEFERRED;
+
+	if (!enh)
+		slow |= TDES0_N_HEARTBEAT_FAIL;
+#ifdef STMMAC_VLAN_TAG_USED
+	else
+		slow |= TDES0_E_VLAN_FRAME;
+#endif
+	if (unlikely(tdes0 & slow))
+		return priv->hw->desc->tx_status(&priv->dev->stats,
+						 &priv->xstats, p,
+						 priv->ioaddr);
+	return 0;
+}
+
+static __always_inline void stmmac_desc_release_tx(struct dma_desc *p,
+						   u32 tdes0, const bool enh)
+{
+	u32 *w = (u32 *)p;
+
+	/* Only the end of ring bit survives */
+	if (enh) {
+		WRITE_ONCE(w[0], tdes0 & TDES0_E_END_RING);
+		WRITE_ONCE(w[1], 0);
+	} else {
+		WRITE_ONCE(w[0], 0);
+		WRITE_ONCE(w[1], stmmac_desc_word(p, 1) & TDES1_N_END_RING);
+	}
+}
+
+static __always_inline int stmmac_desc_rx_status(struct stmmac_priv *priv,
+						 struct dma_desc *p,
+						 u32 rdes0, const bool enh)
+{
+	u32 slow = RDES0_ES | RDES0_DRIBBLING | RDES0_LENGTH_ERROR;
+
+	if (enh) {
+		slow |= RDES0_E_SA_FAIL | RDES0_E_DA_FAIL;
+#ifdef STMMAC_VLAN_TAG_USED
+		slow |= RDES0_E_VLAN_TAG;
+#endif
+	} else
+		slow |= RDES0_N_MII_ERROR | RDES0_N_MULTICAST;
+
+	if (unlikely(rdes0 & slow))
+		return priv->hw->desc->rx_status(&priv->dev->stats,
+						 &priv->xstats, p);
+	if (!enh)
+		return csum_none;
+
+	/* Checksum engine status, as in enh_desc_coe_rdes0 */
+	switch (rdes0 & (RDES0_E_FRAME_TYPE | RDES0_E_IPC_CSUM |
+			 RDES0_E_PAYLOAD_CSUM)) {
+	case 0:
+		return llc_snap;
+	case RDES0_E_PAYLOAD_CSUM:
+	case RDES0_E_IPC_CSUM | RDES0_E_PAYLOAD_CSUM:
+		return discard_frame;
+	case RDES0_E_FRAME_TYPE | RDES0_E_PAYLOAD_CSUM:
+	case RDES0_E_FRAME_TYPE | RDES0_E_IPC_CSUM:
+	case RDES0_E_FRAME_TYPE | RDES0_E_IPC_CSUM | RDES0_E_PAYLOAD_CSUM:
+		return csum_none;
+	default:
+		return good_frame;
+	}
+}
+
+static __always_inline int stmmac_rdes0_frame_len(u32 rdes0)
+{
+	return (rdes0 >> RDES0_FRAME_LEN_SHIFT) & RDES0_FRAME_LEN_MASK;
+}
+
 /**
- * stmmac_tx:
+ * __stmmac_tx:
  * @priv: private driver structure
+ * @budget: maximum number of descriptors to release
+ * @enh: enhanced descriptors
  * Description: it reclaims resources after transmission completes.
+ * Return value: the number of descriptors released.
  */
-static void stmmac_tx(struct stmmac_priv *priv)
+static __always_inline int __stmmac_tx(struct stmmac_priv *priv, int budget,
+				       const bool enh)
 {
-    unsigned int txsize = priv->dma_tx_size;
-
-	while (priv->dirty_tx != priv->cur_tx) {
+	unsigned int bytes_compl = 0, pkts_compl = 0;
+	unsigned int xsk_frames = 0, tx_packets = 0;
+	/* Pairs with stmmac_tx_publish: the entries up to cur are complete */
+	unsigned int cur = smp_load_acquire(&priv->cur_tx);
+	unsigned int dirty = priv->dirty_tx;
+	int count = 0;
+
+	while ((dirty != cur) && (count < budget)) {
 		int last;
-		unsigned int entry = priv->dirty_tx % txsize;
-		struct sk_buff *skb = priv->tx_skbuff[entry];
+		unsigned int entry = STMMAC_TX_ENTRY(priv, dirty);
+		struct stmmac_tx_buffer *tx_buf = priv->tx_buf + entry;
 		struct dma_desc *p = priv->dma_tx + entry;
+		u32 tdes0 = stmmac_desc_word(p, 0);
 
 		/* Check if the descriptor is owned by the DMA. */
-		if (priv->hw->desc->get_tx_owner(p))
+		if (tdes0 & TDES0_OWN)
 			break;
 
 		/* Verify tx error by looking at the last segment */
-		last = priv->hw->desc->get_tx_ls(p);
+		if (enh)
+			last = tdes0 & TDES0_E_LS;
+		else
+			last = stmmac_desc_word(p, 1) & TDES1_N_LS;
 		if (likely(last)) {
-			int tx_error =
-				priv->hw->desc->tx_status(&priv->dev->stats,
-							  &priv->xstats, p,
-							  priv->ioaddr);
-			if (likely(tx_error == 0)) {
-				priv->dev->stats.tx_packets++;
-				priv->xstats.tx_pkt_n++;
-			} else
+			int tx_error = stmmac_desc_tx_status(priv, p, tdes0,
+							     enh);
+			if (likely(tx_error == 0))
+				tx_packets++;
+			else
 				priv->dev->stats.tx_errors++;
 		}
-		TX_DBG("%s: curr %d, dirty %d\n", __func__,
-			priv->cur_tx, priv->dirty_tx);
-
-		if (likely(p->des2))
-			dma_unmap_single(priv->device, p->des2,
-					 priv->hw->desc->get_tx_len(p),
-					 DMA_TO_DEVICE);
-		if (unlikely(p->des3))
-			p->des3 = 0;
-
-		if (likely(skb != NULL)) {
-			/*
-			 * If there's room in the queue (limit it to size)
-			 * we add this skb back into the pool,
-			 * if it's the right size.
-			 */
-			if ((skb_queue_len(&priv->rx_recycle) <
-				priv->dma_rx_size) &&
-				skb_recycle_check(skb, priv->dma_buf_sz))
-				__skb_queue_head(&priv->rx_recycle, skb);
-			else
-				dev_kfree_skb(skb);
-
-			priv->tx_skbuff[entry] = NULL;
+		TX_DBG("%s: curr %d, dirty %d\n", __func__, cur, dirty);
+
+		stmmac_tx_unmap(priv, tx_buf);
+		/* Only the jumbo frames use the second buffer: a write to the
+		 * uncached ring is cheaper than testing it */
+		p->des3 = 0;
+
+		switch (tx_buf->type) {
+		case STMMAC_TXBUF_T_SKB:
+			if (likely(tx_buf->skb != NULL)) {
+				pkts_compl++;
+				bytes_compl += tx_buf->skb->len;
+				dev_kfree_skb(tx_buf->skb);
+			}
+			break;
+		case STMMAC_TXBUF_T_XDP_TX:
+		case STMMAC_TXBUF_T_XDP_NDO:
+			/* Not accounted by BQL */
+			xdp_return_frame(tx_buf->xdpf);
+			break;
+		case STMMAC_TXBUF_T_XSK_TX:
+			xsk_frames++;
+			break;
+		case STMMAC_TXBUF_T_SLOT:
+			if (tx_buf->copy_len) {
+				/* Copied frame: its skb is already gone */
+				pkts_compl++;
+				bytes_compl += tx_buf->copy_len;
+			}
+			break;
 		}
+		memset(tx_buf, 0, sizeof(*tx_buf));
 
-		priv->hw->desc->release_tx_desc(p);
+		stmmac_desc_release_tx(p, tdes0, enh);
 
-		entry = (++priv->dirty_tx) % txsize;
+		dirty++;
+		count++;
 	}
+	/* The cleaned entries go back to the transmit paths */
+	smp_store_release(&priv->dirty_tx, dirty);
+	stmmac_stats_add(&priv->txc_stats, packets, tx_packets);
+	trace_stmmac_tx_clean(priv->dev, count, pkts_compl, bytes_compl,
+			      cur - dirty);
+
+	netdev_completed_queue(priv->dev, pkts_compl, bytes_compl);
+	if (xsk_frames)
+		xsk_tx_completed(priv->xsk_pool, xsk_frames);
+
+	/* Pairs with the smp_mb() in stmmac_tx_stop: either the transmit
+	 * path sees the room or this sees the queue stopped */
+	smp_mb();
 	if (unlikely(netif_queue_stopped(priv->dev) &&
 		     stmmac_tx_avail(priv) > STMMAC_TX_THRESH(priv))) {
-		netif_tx_lock(priv->dev);
-		if (netif_queue_stopped(priv->dev) &&
-		     stmmac_tx_avail(priv) > STMMAC_TX_THRESH(priv)) {
-			TX_DBG("%s: restart transmit\n", __func__);
-			netif_wake_queue(priv->dev);
-		}
-		netif_tx_unlock(priv->dev);
+		TX_DBG("%s: restart transmit\n", __func__);
+		netif_wake_queue(priv->dev);
 	}
+
+	return count;
 }
 
-static inline void stmmac_enable_irq(struct stmmac_priv *priv)
+static int stmmac_tx(struct stmmac_priv *priv, int budget)
 {
-#ifdef CONFIG_STMMAC_TIMER
-	if (likely(priv->tm->enable))
-		priv->tm->timer_start(tmrate);
-	else
-#endif
-		priv->hw->dma->enable_dma_irq(priv->ioaddr);
+	if (priv->plat->enh_desc)
+		return __stmmac_tx(priv, budget, true);
+	return __stmmac_tx(priv, budget, false);
 }
 
-static inline void stmmac_disable_irq(struct stmmac_priv *priv)
+/* The TX interrupt is only used by the "irq" completion strategy */
+static inline void stmmac_enable_irq(struct stmmac_priv *priv, bool rx,
+				     bool tx)
 {
+	unsigned long flags;
+
+	tx = tx && (READ_ONCE(priv->tx_completion) == TX_COMPLETION_IRQ);
+	if (!rx && !tx)
+		return;
 #ifdef CONFIG_STMMAC_TIMER
 	if (likely(priv->tm->enable))
-		priv->tm->timer_stop();
+		priv->tm->timer_start(priv->tm, priv->tm->freq);
 	else
 #endif
-		priv->hw->dma->disable_dma_irq(priv->ioaddr);
+	{
+		spin_lock_irqsave(&priv->irq_lock, flags);
+		priv->hw->dma->enable_dma_irq(priv->ioaddr, rx, tx);
+		spin_unlock_irqrestore(&priv->irq_lock, flags);
+	}
 }
 
-static inline int stmmac_has_work(struct stmmac_priv *priv)
+static inline void stmmac_disable_irq(struct stmmac_priv *priv, bool rx,
+				      bool tx)
 {
-	unsigned int has_work = 0;
-	int rxret, tx_work = 0;
+	unsigned long flags;
 
-	rxret = priv->hw->desc->get_rx_owner(priv->dma_rx +
-		(priv->cur_rx % priv->dma_rx_size));
+	tx = tx && (READ_ONCE(priv->tx_completion) == TX_COMPLETION_IRQ);
+	if (!rx && !tx)
+		return;
+#ifdef CONFIG_STMMAC_TIMER
+	if (likely(priv->tm->enable))
+		priv->tm->timer_stop(priv->tm);
+	else
+#endif
+	{
+		spin_lock_irqsave(&priv->irq_lock, flags);
+		priv->hw->dma->disable_dma_irq(priv->ioaddr, rx, tx);
+		spin_unlock_irqrestore(&priv->irq_lock, flags);
+	}
+}
 
-	if (priv->dirty_tx != priv->cur_tx)
-		tx_work = 1;
+static inline int stmmac_rx_has_work(struct stmmac_priv *priv)
+{
+	unsigned int entry = STMMAC_RX_ENTRY(priv, priv->cur_rx);
 
-	if (likely(!rxret || tx_work))
-		has_work = 1;
+	stmmac_rx_desc_sync_line(priv, entry);
+	return !priv->hw->desc->get_rx_owner(priv->dma_rx + entry);
+}
 
-	return has_work;
+static inline int stmmac_tx_has_work(struct stmmac_priv *priv)
+{
+	return READ_ONCE(priv->dirty_tx) != READ_ONCE(priv->cur_tx);
+}
+
+#ifdef CONFIG_SILAN_GMAC_POLL_HIST
+/* The first poll after the NAPI has been scheduled measures the delay */
+static inline void stmmac_hist_poll_delay(u64 *stamp, struct stmmac_hist *h)
+{
+	if (*stamp) {
+		stmmac_hist_add(h, sched_clock() - *stamp);
+		*stamp = 0;
+	}
+}
+
+/* Descriptors the DMA has closed and the poll has not processed yet; one
+ * register read, the ring itself is not walked */
+static inline unsigned int stmmac_rx_ring_ready(struct stmmac_priv *priv)
+{
+	u32 desc = readl(priv->ioaddr + DMA_HOST_RX_DESC);
+	unsigned int entry;
+
+	entry = (desc - priv->dma_rx_phy) / sizeof(struct dma_desc);
+	return STMMAC_RX_ENTRY(priv, entry - priv->cur_rx);
+}
+
+static inline void stmmac_hist_rx_start(struct stmmac_priv *priv)
+{
+	stmmac_hist_poll_delay(&priv->hist.rx_stamp, &priv->hist.rx_delay);
+	stmmac_hist_add(&priv->hist.rx_ring, stmmac_rx_ring_ready(priv));
 }
 
-static inline void _stmmac_schedule(struct stmmac_priv *priv)
+static inline void stmmac_hist_rx_end(struct stmmac_priv *priv,
+				      int work_done, int budget)
 {
-	if (likely(stmmac_has_work(priv))) {
-		stmmac_disable_irq(priv);
-		napi_schedule(&priv->napi);
-#ifdef CONFIG_SILAN_GMAC_TX_POSTCHK
-        priv->napi_state = NAPI_ON;
+	stmmac_hist_add(&priv->hist.rx_work, work_done);
+	stmmac_hist_add(&priv->hist.rx_short, priv->cur_rx - priv->dirty_rx);
+	if (work_done >= budget)
+		priv->hist.rx_budget_n++;
+}
+
+static inline void stmmac_hist_tx_start(struct stmmac_priv *priv)
+{
+	stmmac_hist_poll_delay(&priv->hist.tx_stamp, &priv->hist.tx_delay);
+}
+
+static inline void stmmac_hist_tx_end(struct stmmac_priv *priv,
+				      int count, int budget)
+{
+	stmmac_hist_add(&priv->hist.tx_batch, count);
+	if (count >= budget)
+		priv->hist.tx_budget_n++;
+}
+
+#define stmmac_hist_stamp(stamp)	((stamp) = sched_clock())
+#else
+static inline void stmmac_hist_rx_start(struct stmmac_priv *priv) {}
+static inline void stmmac_hist_rx_end(struct stmmac_priv *priv,
+				      int work_done, int budget) {}
+static inline void stmmac_hist_tx_start(struct stmmac_priv *priv) {}
+static inline void stmmac_hist_tx_end(struct stmmac_priv *priv,
+				      int count, int budget) {}
+
+#define stmmac_hist_stamp(stamp)	do { } while (0)
 #endif
-    }
+
+/* Each direction masks its own interrupt while its NAPI is scheduled */
+static inline void stmmac_schedule_rx(struct stmmac_priv *priv)
+{
+	if (likely(napi_schedule_prep(&priv->napi))) {
+		stmmac_hist_stamp(priv->hist.rx_stamp);
+		stmmac_disable_irq(priv, true, false);
+		__napi_schedule(&priv->napi);
+	}
+}
+
+static inline void stmmac_schedule_tx(struct stmmac_priv *priv)
+{
+	if (likely(napi_schedule_prep(&priv->tx_napi))) {
+		stmmac_hist_stamp(priv->hist.tx_stamp);
+		stmmac_disable_irq(priv, false, true);
+		__napi_schedule(&priv->tx_napi);
+	}
+}
+
+/**
+ * stmmac_rx_coalesce_apply - ask for new RX coalescing parameters
+ * @priv: private driver structure
+ * Description: called from ethtool and from the DIM work once rx_riwt
+ * and rx_coal_frames are updated. The RX NAPI programs them at its next
+ * poll, so the ring is never rewritten behind the refill.
+ */
+void stmmac_rx_coalesce_apply(struct stmmac_priv *priv)
+{
+	smp_store_release(&priv->rx_coal_update, true);
+
+	if (!netif_running(priv->dev))
+		return;
+
+	local_bh_disable();
+	stmmac_schedule_rx(priv);
+	local_bh_enable();
+}
+
+/**
+ * stmmac_tx_completion_irq - program the TX interrupt mask
+ * @priv: private driver structure
+ * Description: the TX interrupt is unmasked only for the "irq" completion
+ * strategy; "postchk" and "timer" reclaim without it.
+ */
+static void stmmac_tx_completion_irq(struct stmmac_priv *priv)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&priv->irq_lock, flags);
+	if (priv->tx_completion == TX_COMPLETION_IRQ)
+		priv->hw->dma->enable_dma_irq(priv->ioaddr, false, true);
+	else
+		priv->hw->dma->disable_dma_irq(priv->ioaddr, false, true);
+	spin_unlock_irqrestore(&priv->irq_lock, flags);
+}
+
+static inline void stmmac_arm_tx_timer(struct stmmac_priv *priv)
+{
+	if (!timer_pending(&priv->txtimer))
+		mod_timer(&priv->txtimer,
+			  jiffies + usecs_to_jiffies(priv->tx_coal_timer));
+}
+
+/**
+ * stmmac_tx_timer - TX coalescing timer
+ * @t: the timer embedded in the private structure
+ * Description: frames queued without the interrupt on completion are
+ * reclaimed from here when no other interrupt comes in the meantime.
+ */
+static void stmmac_tx_timer(struct timer_list *t)
+{
+	struct stmmac_priv *priv = from_timer(priv, t, txtimer);
+
+	stmmac_schedule_tx(priv);
 }
 
 #ifdef CONFIG_STMMAC_TIMER
@@ -776,38 +1600,78 @@ void stmmac_schedule(struct net_device *dev)
 
 	priv->xstats.sched_timer_n++;
 
-	_stmmac_schedule(priv);
+	if (stmmac_rx_has_work(priv))
+		stmmac_schedule_rx(priv);
+	if (stmmac_tx_has_work(priv))
+		stmmac_schedule_tx(priv);
 }
 
-static void stmmac_no_timer_started(unsigned int x)
+static void stmmac_no_timer_started(struct stmmac_timer *tm, unsigned int x)
 {;
 };
 
-static void stmmac_no_timer_stopped(void)
+static void stmmac_no_timer_stopped(struct stmmac_timer *tm)
 {;
 };
 #endif
 
 /**
- * stmmac_tx_err:
- * @priv: pointer to the private device structure
- * Description: it cleans the descriptors and restarts the transmission
- * in case of errors.
+ * stmmac_tx_err_work - reset the TX ring after an error
+ * @work: work embedded in the private structure
+ * Description: it cleans the descriptors and restarts the transmission.
+ * The TX NAPI and the transmit paths own cur_tx, dirty_tx and the tx_buf
+ * entries: they are stopped first, so this cannot run from the interrupt.
  */
-static void stmmac_tx_err(struct stmmac_priv *priv)
+static void stmmac_tx_err_work(struct work_struct *work)
 {
+	struct stmmac_priv *priv = container_of(work, struct stmmac_priv,
+						tx_err_work);
+	struct net_device *dev = priv->dev;
 
-	netif_stop_queue(priv->dev);
+	napi_disable(&priv->tx_napi);
+	netif_tx_lock_bh(dev);
+	trace_stmmac_tx_err(dev, priv->cur_tx, priv->dirty_tx);
 
 	priv->hw->dma->stop_tx(priv->ioaddr);
 	dma_free_tx_skbufs(priv);
 	priv->hw->desc->init_tx_desc(priv->dma_tx, priv->dma_tx_size);
 	priv->dirty_tx = 0;
 	priv->cur_tx = 0;
+	priv->tx_count_frames = 0;
+	netdev_reset_queue(dev);
 	priv->hw->dma->start_tx(priv->ioaddr);
+	dev->stats.tx_errors++;
+
+	netif_tx_unlock_bh(dev);
+	napi_enable(&priv->tx_napi);
+	netif_wake_queue(dev);
+}
+
+/* From the DMA interrupt and the TX watchdog. Once the device is down or
+ * detached the reset is no longer scheduled, see stmmac_tx_err_sync. */
+static void stmmac_tx_err(struct stmmac_priv *priv)
+{
+	if (likely(netif_running(priv->dev) &&
+		   netif_device_present(priv->dev)))
+		schedule_work(&priv->tx_err_work);
+}
+
+/**
+ * stmmac_tx_err_sync - wait for the TX ring reset
+ * @priv: driver private structure
+ * Description: the close, the quiesce and the suspend call it once the
+ * device is down or detached, before they stop the TX NAPI themselves:
+ * after the running interrupt handler and TX watchdog no new reset can
+ * be scheduled.
+ */
+static void stmmac_tx_err_sync(struct stmmac_priv *priv)
+{
+	struct net_device *dev = priv->dev;
 
-	priv->dev->stats.tx_errors++;
-	netif_wake_queue(priv->dev);
+	synchronize_irq(dev->irq);
+	netif_tx_lock_bh(dev);
+	netif_tx_unlock_bh(dev);
+	cancel_work_sync(&priv->tx_err_work);
 }
 
 
@@ -816,22 +1680,22 @@ static void stmmac_dma_interrupt(struct stmmac_priv *priv)
 	int status;
 
 	status = priv->hw->dma->dma_interrupt(priv->ioaddr, &priv->xstats);
-#ifdef CONFIG_SILAN_GMAC_TX_POSTCHK
-    if (likely(status == handle_rx))
-#else
-	if (likely(status == handle_tx_rx))
-#endif
-		_stmmac_schedule(priv);
+	if (likely(status & handle_rx))
+		stmmac_schedule_rx(priv);
+	if (likely(status & handle_tx))
+		stmmac_schedule_tx(priv);
 
-    else if (unlikely(status == tx_hard_error_bump_tc)) {
+	if (unlikely(status & tx_hard_error))
+		stmmac_tx_err(priv);
+	else if (unlikely(status & tx_hard_error_bump_tc)) {
 		/* Try to bump up the dma threshold on this failure */
 		if (unlikely(tc != SF_DMA_MODE) && (tc <= 256)) {
 			tc += 64;
 			priv->hw->dma->dma_mode(priv->ioaddr, tc, SF_DMA_MODE);
 			priv->xstats.threshold = tc;
+			trace_stmmac_tc_bump(priv->dev, tc);
 		}
-	} else if (unlikely(status == tx_hard_error))
-		stmmac_tx_err(priv);
+	}
 }
 
 /**
@@ -853,25 +1717,25 @@ static int stmmac_open(struct net_device *dev)
 	 * address using the following linux command:
 	 *      ifconfig eth0 hw ether xx:xx:xx:xx:xx:xx  */
 	if (!is_valid_ether_addr(dev->dev_addr)) {
-		random_ether_addr(dev->dev_addr);
-		pr_warning("%s: generated random MAC address %pM\n", dev->name,
+		eth_hw_addr_random(dev);
+		pr_warn("%s: generated random MAC address %pM\n", dev->name,
 			dev->dev_addr);
 	}
 
 	stmmac_verify_args();
 
 #ifdef CONFIG_STMMAC_TIMER
-	priv->tm = kzalloc(sizeof(struct stmmac_timer *), GFP_KERNEL);
+	priv->tm = kzalloc(sizeof(struct stmmac_timer), GFP_KERNEL);
 	if (unlikely(priv->tm == NULL)) {
 		pr_err("%s: ERROR: timer memory alloc failed\n", __func__);
 		return -ENOMEM;
 	}
-	priv->tm->freq = tmrate;
+	priv->tm->freq = priv->tmrate;
 
 	/* Test if the external timer can be actually used.
 	 * In case of failure continue without timer. */
 	if (unlikely((stmmac_open_ext_timer(dev, priv->tm)) < 0)) {
-		pr_warning("stmmaceth: cannot attach the external timer.\n");
+		pr_warn("stmmaceth: cannot attach the external timer.\n");
 		priv->tm->freq = 0;
 		priv->tm->timer_start = stmmac_no_timer_started;
 		priv->tm->timer_stop = stmmac_no_timer_stopped;
@@ -889,20 +1753,31 @@ static int stmmac_open(struct net_device *dev)
 		priv->dma_tx_size = STMMAC_ALIGN(GMAC_SRAM_DMA_TX_SIZE);
 		priv->dma_rx_size = STMMAC_ALIGN(GMAC_SRAM_DMA_RX_SIZE);
 	}
-	else {
+	else if (!priv->dma_tx_size) {
+		/* The sizes set by ethtool -G survive down/up cycles */
 		priv->dma_tx_size = STMMAC_ALIGN(dma_txsize);
 		priv->dma_rx_size = STMMAC_ALIGN(dma_rxsize);
 	}
 	priv->dma_buf_sz = STMMAC_ALIGN(buf_sz);
-	init_dma_desc_rings(dev);
+	ret = init_dma_desc_rings(dev);
+	if (ret < 0) {
+		pr_err("%s: DMA rings initialization failed\n", __func__);
+		free_dma_desc_resources(priv);
+		goto open_error;
+	}
 
 	/* DMA initialization and SW reset */
 	ret = priv->hw->dma->init(priv->ioaddr, priv->plat->pbl,
 				  priv->dma_tx_phy, priv->dma_rx_phy);
 	if (ret < 0) {
 		pr_err("%s: DMA initialization failed\n", __func__);
+		free_dma_desc_resources(priv);
 		goto open_error;
 	}
+	/* The DMA reset has cleared the RX watchdog and unmasked TX */
+	priv->rx_coal_update = false;
+	stmmac_rx_coalesce_write(priv);
+	stmmac_tx_completion_irq(priv);
 
 	/* Copy the MAC addr into the HW  */
 	priv->hw->mac->set_umac_addr(priv->ioaddr, dev->dev_addr, 0);
@@ -919,7 +1794,8 @@ static int stmmac_open(struct net_device *dev)
 		pr_info("\tTX Checksum insertion supported\n");
 	netdev_update_features(dev);
 
-	/* Initialise the MMC (if present) to disable all interrupts. */
+	/* Initialise the MMC (if present) to disable all interrupts; the
+	 * counters are collected by stmmac_mmc.c */
 	writel(0xffffffff, priv->ioaddr + MMC_HIGH_INTR_MASK);
 	writel(0xffffffff, priv->ioaddr + MMC_LOW_INTR_MASK);
 
@@ -929,6 +1805,7 @@ static int stmmac_open(struct net_device *dev)
 	if (unlikely(ret < 0)) {
 		pr_err("%s: ERROR: allocating the IRQ %d (name:%s, error: %d)\n",
 		       __func__, dev->irq, dev->name, ret);
+		free_dma_desc_resources(priv);
 		goto open_error;
 	}
 
@@ -941,6 +1818,18 @@ static int stmmac_open(struct net_device *dev)
 	/* Extra statistics */
 	memset(&priv->xstats, 0, sizeof(struct stmmac_extra_stats));
 	priv->xstats.threshold = tc;
+	/* The per packet counters survive down/up cycles, as dev->stats */
+	priv->rx_sync_saved_last =
+		u64_stats_read(&priv->rx_stats.sync_saved_bytes);
+	priv->rx_sync_stamp = jiffies;
+
+	/* Adaptive interrupt moderation restarts from the first profile */
+	memset(&priv->rx_dim, 0, sizeof(priv->rx_dim));
+	memset(&priv->tx_dim, 0, sizeof(priv->tx_dim));
+	INIT_WORK(&priv->rx_dim.work, stmmac_rx_dim_work);
+	INIT_WORK(&priv->tx_dim.work, stmmac_tx_dim_work);
+	priv->rx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+	priv->tx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
 
 	/* Start the ball rolling... */
 	DBG(probe, DEBUG, "%s: DMA RX/TX processes started...\n", dev->name);
@@ -948,7 +1837,7 @@ static int stmmac_open(struct net_device *dev)
 	priv->hw->dma->start_rx(priv->ioaddr);
 
 #ifdef CONFIG_STMMAC_TIMER
-	priv->tm->timer_start(tmrate);
+	priv->tm->timer_start(priv->tm, priv->tm->freq);
 #endif
 	/* Dump DMA/MAC registers */
 	if (netif_msg_hw(priv)) {
@@ -960,12 +1849,12 @@ static int stmmac_open(struct net_device *dev)
 		phy_start(priv->phydev);
 
 	napi_enable(&priv->napi);
-	skb_queue_head_init(&priv->rx_recycle);
-
-#ifdef CONFIG_SILAN_GMAC_TX_POSTCHK
-    /* For Tx post-check */
-    priv->napi_state = NAPI_OFF;
-#endif
+	napi_enable(&priv->tx_napi);
+	netdev_reset_queue(dev);
+	priv->tx_count_frames = 0;
+	timer_setup(&priv->txtimer, stmmac_tx_timer, 0);
+	stmmac_mmc_init(priv);
+	stmmac_hist_register(priv);
 
 	netif_start_queue(dev);
 
@@ -988,6 +1877,13 @@ open_error:
 	return ret;
 }
 
+/* The rings of an open interface are only missing after a failed
+ * stmmac_rebuild_rings: it then stays quiesced and detached */
+static inline bool stmmac_rings_lost(struct stmmac_priv *priv)
+{
+	return priv->rx_buf == NULL;
+}
+
 /**
  *  stmmac_release - close entry point of the driver
  *  @dev : device pointer.
@@ -997,6 +1893,7 @@ open_error:
 static int stmmac_release(struct net_device *dev)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
+	bool lost = stmmac_rings_lost(priv);
 
 	/* Stop and disconnect the PHY */
 	if (priv->phydev) {
@@ -1006,15 +1903,28 @@ static int stmmac_release(struct net_device *dev)
 	}
 
 	netif_stop_queue(dev);
+	stmmac_tx_err_sync(priv);
+	del_timer_sync(&priv->txtimer);
+	stmmac_mmc_stop(priv);
+	stmmac_hist_unregister(priv);
 
 #ifdef CONFIG_STMMAC_TIMER
 	/* Stop and release the timer */
-	stmmac_close_ext_timer();
+	if (likely(priv->tm->enable))
+		stmmac_close_ext_timer(priv->tm);
 	if (priv->tm != NULL)
 		kfree(priv->tm);
 #endif
-	napi_disable(&priv->napi);
-	skb_queue_purge(&priv->rx_recycle);
+	/* stmmac_quiesce has already disabled them */
+	if (!lost) {
+		napi_disable(&priv->napi);
+		napi_disable(&priv->tx_napi);
+	}
+	cancel_work_sync(&priv->rx_dim.work);
+	cancel_work_sync(&priv->tx_dim.work);
+#ifdef CONFIG_SILAN_GMAC_FWD
+	stmmac_fwd_flush(stmmac_fwd_port(priv));
+#endif
 
 	/* Free the IRQ lines */
 	free_irq(dev->irq, dev);
@@ -1031,48 +1941,441 @@ static int stmmac_release(struct net_device *dev)
 
 	netif_carrier_off(dev);
 
+	/* The next open starts from scratch */
+	if (lost && !netif_running(dev))
+		netif_device_attach(dev);
+
 	return 0;
 }
 
-static unsigned int stmmac_handle_jumbo_frames(struct sk_buff *skb,
-					       struct net_device *dev,
-					       int csum_insertion)
+/**
+ * stmmac_quiesce - stop the traffic of a running interface
+ * @priv: private driver structure
+ * Description: unlike stmmac_release, it leaves the PHY, the MAC and the IRQ
+ * line alone: only the queue, the NAPI contexts, the timers, the DIM works,
+ * the DMA and its interrupts are stopped. The detached device also keeps
+ * the XDP and forwarding paths off the TX ring.
+ */
+static void stmmac_quiesce(struct stmmac_priv *priv)
+{
+	struct net_device *dev = priv->dev;
+	unsigned long flags;
+
+	netif_device_detach(dev);
+	/* Wait for the transmitters that were already holding the lock and
+	 * for a TX ring reset */
+	stmmac_tx_err_sync(priv);
+
+#ifdef CONFIG_STMMAC_TIMER
+	priv->tm->timer_stop(priv->tm);
+#endif
+	napi_disable(&priv->napi);
+	napi_disable(&priv->tx_napi);
+	del_timer_sync(&priv->txtimer);
+	/* The RX DIM work rewrites the coalescing of the ring */
+	cancel_work_sync(&priv->rx_dim.work);
+	cancel_work_sync(&priv->tx_dim.work);
+
+	/* Stopping the DMA raises its "process stopped" status: with every
+	 * DMA interrupt masked stmmac_dma_interrupt leaves the rings alone */
+	spin_lock_irqsave(&priv->irq_lock, flags);
+	writel(0, priv->ioaddr + DMA_INTR_ENA);
+	spin_unlock_irqrestore(&priv->irq_lock, flags);
+	synchronize_irq(dev->irq);
+
+	priv->hw->dma->stop_tx(priv->ioaddr);
+	priv->hw->dma->stop_rx(priv->ioaddr);
+}
+
+/* Counterpart of stmmac_quiesce, once the rings have been rebuilt */
+static void stmmac_unquiesce(struct stmmac_priv *priv)
+{
+	struct net_device *dev = priv->dev;
+	unsigned long flags;
+
+	priv->hw->dma->set_rings(priv->ioaddr, priv->dma_tx_phy,
+				 priv->dma_rx_phy);
+	netdev_reset_queue(dev);
+	priv->tx_count_frames = 0;
+	/* It depends on the MTU (see stmmac_change_mtu) */
+	stmmac_dma_operation_mode(priv);
+	/* The new RX ring comes with the default IC bits */
+	priv->rx_coal_update = false;
+	stmmac_rx_coalesce_write(priv);
+
+	priv->hw->dma->start_tx(priv->ioaddr);
+	priv->hw->dma->start_rx(priv->ioaddr);
+#ifdef CONFIG_STMMAC_TIMER
+	priv->tm->timer_start(priv->tm, priv->tm->freq);
+#endif
+	napi_enable(&priv->napi);
+	napi_enable(&priv->tx_napi);
+	/* A decision cancelled by stmmac_quiesce left DIM waiting for it */
+	priv->rx_dim.state = DIM_START_MEASURE;
+	priv->tx_dim.state = DIM_START_MEASURE;
+
+	netif_device_attach(dev);
+
+	/* Forget the status raised by the stop, then unmask as at open */
+	writel(0x1ffff, priv->ioaddr + DMA_STATUS);
+	spin_lock_irqsave(&priv->irq_lock, flags);
+	writel(DMA_INTR_DEFAULT_MASK, priv->ioaddr + DMA_INTR_ENA);
+	spin_unlock_irqrestore(&priv->irq_lock, flags);
+	stmmac_tx_completion_irq(priv);
+}
+
+/* What the rings of a running interface are built for */
+struct stmmac_ring_cfg {
+	unsigned int rxsize;
+	unsigned int txsize;
+	int mtu;
+	int no_csum;
+	struct bpf_prog *prog;
+	struct xsk_buff_pool *pool;
+};
+
+static void stmmac_ring_cfg_get(struct stmmac_priv *priv,
+				struct stmmac_ring_cfg *cfg)
+{
+	cfg->rxsize = priv->dma_rx_size;
+	cfg->txsize = priv->dma_tx_size;
+	cfg->mtu = priv->dev->mtu;
+	cfg->no_csum = priv->no_csum_insertion;
+	cfg->prog = priv->xdp_prog;
+	cfg->pool = priv->xsk_pool;
+}
+
+static void stmmac_ring_cfg_set(struct stmmac_priv *priv,
+				const struct stmmac_ring_cfg *cfg)
+{
+	priv->dma_rx_size = cfg->rxsize;
+	priv->dma_tx_size = cfg->txsize;
+	priv->dev->mtu = cfg->mtu;
+	priv->no_csum_insertion = cfg->no_csum;
+	/* The RX path only looks at it once the NAPI contexts are back */
+	WRITE_ONCE(priv->xdp_prog, cfg->prog);
+	priv->xsk_pool = cfg->pool;
+}
+
+/**
+ * stmmac_rebuild_rings - reallocate the rings of a running interface
+ * @dev: net device structure
+ * @cfg: ring sizes, MTU, checksum mode, XDP program and AF_XDP pool to
+ * build them for
+ * Description: the rings and their buffers are reallocated during a brief
+ * quiesce, the link stays up. The frames in flight are dropped. The old
+ * rings are released with the old configuration, the new ones take their
+ * headroom, DMA direction and buffers from @cfg (see init_dma_desc_rings).
+ * If the new rings cannot be allocated the previous configuration is
+ * restored. If even that fails the error is returned and the interface is
+ * left quiesced: detached, with its NAPI contexts and DMA interrupts off
+ * (see stmmac_rings_lost), until a later rebuild succeeds or it is closed.
+ * Either way the DMA mode is only programmed while the DMA is stopped (see
+ * stmmac_unquiesce).
+ */
+static int stmmac_rebuild_rings(struct net_device *dev,
+				const struct stmmac_ring_cfg *cfg)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	struct stmmac_ring_cfg old;
+	int ret;
+
+	stmmac_ring_cfg_get(priv, &old);
+
+	if (!stmmac_rings_lost(priv))
+		stmmac_quiesce(priv);
+
+	free_dma_desc_resources(priv);
+	stmmac_ring_cfg_set(priv, cfg);
+	ret = init_dma_desc_rings(dev);
+	if (ret < 0) {
+		pr_err("%s: cannot allocate the new rings, restoring\n",
+		       dev->name);
+		free_dma_desc_resources(priv);
+		stmmac_ring_cfg_set(priv, &old);
+		if (init_dma_desc_rings(dev) < 0) {
+			pr_err("%s: no DMA rings, the interface is stopped\n",
+			       dev->name);
+			free_dma_desc_resources(priv);
+			return ret;
+		}
+	}
+
+	/* The coalescing limits depend on the ring sizes */
+	priv->rx_coal_frames = min(priv->rx_coal_frames, priv->dma_rx_size);
+	priv->tx_coal_frames = min(priv->tx_coal_frames,
+				   priv->dma_tx_size / 2);
+
+	stmmac_unquiesce(priv);
+
+	return ret;
+}
+
+/**
+ * stmmac_reinit_rings - resize the descriptor rings
+ * @dev: net device structure
+ * @rxsize: number of RX descriptors
+ * @txsize: number of TX descriptors
+ * Description: the interface gets its new rings at once (see
+ * stmmac_rebuild_rings). It is running: the ethtool .begin hook refuses
+ * the request otherwise.
+ */
+int stmmac_reinit_rings(struct net_device *dev, unsigned int rxsize,
+			unsigned int txsize)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	struct stmmac_ring_cfg cfg;
+
+	/* The SRAM holds fixed size rings */
+	if (desc_in_sram(priv->platform_id))
+		return -EOPNOTSUPP;
+
+	stmmac_ring_cfg_get(priv, &cfg);
+	cfg.rxsize = rxsize;
+	cfg.txsize = txsize;
+
+	return stmmac_rebuild_rings(dev, &cfg);
+}
+
+/**
+ * stmmac_tx_close - close the last descriptor of a frame
+ * @priv: private driver structure
+ * @desc: last descriptor of the frame
+ * Description: the interrupt on completion is requested only once every
+ * tx_coal_frames frames: the timer reclaims the tail of a burst if no other
+ * interrupt follows it.
+ */
+static inline void stmmac_tx_close(struct stmmac_priv *priv,
+				   struct dma_desc *desc)
+{
+	priv->hw->desc->close_tx_desc(desc);
+
+	if (++priv->tx_count_frames < priv->tx_coal_frames) {
+		priv->hw->desc->clear_tx_ic(desc);
+		stmmac_arm_tx_timer(priv);
+	} else
+		priv->tx_count_frames = 0;
+
+#ifdef CONFIG_STMMAC_TIMER
+	/* Clean IC while using timer */
+	if (likely(priv->tm->enable))
+		priv->hw->desc->clear_tx_ic(desc);
+#endif
+}
+
+/* Start the TX completion of the strategies without the TX interrupt */
+static inline void stmmac_tx_completion_kick(struct stmmac_priv *priv)
+{
+	switch (READ_ONCE(priv->tx_completion)) {
+	case TX_COMPLETION_POSTCHK:
+		/* No TX interrupt, the TX NAPI reclaims what is done */
+		stmmac_schedule_tx(priv);
+		break;
+	case TX_COMPLETION_TIMER:
+		stmmac_arm_tx_timer(priv);
+		break;
+	default:
+		break;
+	}
+}
+
+/* On a mapping error, *cur is the entry that failed: the ones before it
+ * are left to stmmac_tx_unwind */
+static int stmmac_handle_jumbo_frames(struct sk_buff *skb,
+				      struct net_device *dev,
+				      int csum_insertion, unsigned int *cur)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
 	unsigned int nopaged_len = skb_headlen(skb);
-	unsigned int txsize = priv->dma_tx_size;
-	unsigned int entry = priv->cur_tx % txsize;
+	unsigned int entry = STMMAC_TX_ENTRY(priv, *cur);
+	struct stmmac_tx_buffer *tx_buf = priv->tx_buf + entry;
 	struct dma_desc *desc = priv->dma_tx + entry;
 
 	if (nopaged_len > BUF_SIZE_8KiB) {
 
 		int buf2_size = nopaged_len - BUF_SIZE_8KiB;
 
-		desc->des2 = dma_map_single(priv->device, skb->data,
-					    BUF_SIZE_8KiB, DMA_TO_DEVICE);
-		desc->des3 = desc->des2 + BUF_SIZE_4KiB;
+		tx_buf->dma = dma_map_single(priv->device, skb->data,
+					     BUF_SIZE_8KiB, DMA_TO_DEVICE);
+		if (unlikely(dma_mapping_error(priv->device, tx_buf->dma)))
+			goto dma_map_err;
+		tx_buf->len = BUF_SIZE_8KiB;
+		desc->des2 = tx_buf->dma;
+		desc->des3 = tx_buf->dma + BUF_SIZE_4KiB;
 		priv->hw->desc->prepare_tx_desc(desc, 1, BUF_SIZE_8KiB,
 						csum_insertion);
 
-		entry = (++priv->cur_tx) % txsize;
+		entry = STMMAC_TX_ENTRY(priv, ++(*cur));
+		tx_buf = priv->tx_buf + entry;
 		desc = priv->dma_tx + entry;
 
-		desc->des2 = dma_map_single(priv->device,
-					skb->data + BUF_SIZE_8KiB,
-					buf2_size, DMA_TO_DEVICE);
-		desc->des3 = desc->des2 + BUF_SIZE_4KiB;
+		tx_buf->skb = NULL;
+		tx_buf->dma = dma_map_single(priv->device,
+					     skb->data + BUF_SIZE_8KiB,
+					     buf2_size, DMA_TO_DEVICE);
+		if (unlikely(dma_mapping_error(priv->device, tx_buf->dma)))
+			goto dma_map_err;
+		tx_buf->len = buf2_size;
+		desc->des2 = tx_buf->dma;
+		desc->des3 = tx_buf->dma + BUF_SIZE_4KiB;
 		priv->hw->desc->prepare_tx_desc(desc, 0, buf2_size,
 						csum_insertion);
 		priv->hw->desc->set_tx_owner(desc);
-		priv->tx_skbuff[entry] = NULL;
 	} else {
-		desc->des2 = dma_map_single(priv->device, skb->data,
-					nopaged_len, DMA_TO_DEVICE);
-		desc->des3 = desc->des2 + BUF_SIZE_4KiB;
+		tx_buf->dma = dma_map_single(priv->device, skb->data,
+					     nopaged_len, DMA_TO_DEVICE);
+		if (unlikely(dma_mapping_error(priv->device, tx_buf->dma)))
+			goto dma_map_err;
+		tx_buf->len = nopaged_len;
+		desc->des2 = tx_buf->dma;
+		desc->des3 = tx_buf->dma + BUF_SIZE_4KiB;
 		priv->hw->desc->prepare_tx_desc(desc, 1, nopaged_len,
 						csum_insertion);
 	}
-	return entry;
+	return 0;
+
+dma_map_err:
+	tx_buf->dma = 0;
+	return -ENOMEM;
+}
+
+/**
+ * stmmac_tx_unwind - drop a chain that was not published
+ * @priv: driver private structure
+ * @cur: end of the chain
+ * Description: the entries from cur_tx on are unmapped and their
+ * descriptors given back to the CPU. The first descriptor of the chain
+ * was never handed over, so the DMA has not started on any of them.
+ */
+static void stmmac_tx_unwind(struct stmmac_priv *priv, unsigned int cur)
+{
+	unsigned int i;
+
+	for (i = priv->cur_tx; i != cur; i++) {
+		unsigned int entry = STMMAC_TX_ENTRY(priv, i);
+		struct stmmac_tx_buffer *tx_buf = priv->tx_buf + entry;
+
+		stmmac_tx_unmap(priv, tx_buf);
+		memset(tx_buf, 0, sizeof(*tx_buf));
+		priv->hw->desc->release_tx_desc(priv->dma_tx + entry);
+	}
+}
+
+/**
+ * stmmac_tso_xmit - software TSO
+ * @skb: the GSO skb
+ * @dev: device pointer
+ * Description: the GMAC has no TSO engine. Each segment gets its own copy
+ * of the headers, built by net/tso in the coherent TX slot, followed by
+ * descriptors pointing straight into the payload of the skb; the checksum
+ * engine fills in the IP and TCP checksums. The skb is released with the
+ * last descriptor, once all the segments are out.
+ */
+static netdev_tx_t stmmac_tso_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	struct dma_desc *desc = NULL, *first = NULL;
+	struct stmmac_tx_buffer *tx_buf;
+	unsigned int entry = 0, wire_len = 0, segs = 0;
+	unsigned int cur = priv->cur_tx;
+	int hdr_len, total_len;
+	struct netdev_queue *txq;
+	struct tso_t tso;
+	bool kick;
+
+	/* ndo_features_check bounds the skb by the room left while the
+	 * queue is awake */
+	if (unlikely(stmmac_tx_avail(priv) < tso_count_descs(skb))) {
+		if (!netif_queue_stopped(dev)) {
+			stmmac_tx_stop(priv);
+			pr_err("%s: BUG! Tx Ring full when queue awake\n",
+			       __func__);
+		}
+		return NETDEV_TX_BUSY;
+	}
+
+	hdr_len = tso_start(skb, &tso);
+	total_len = skb->len - hdr_len;
+
+	while (total_len > 0) {
+		int data_left = min_t(int, skb_shinfo(skb)->gso_size,
+				      total_len);
+
+		total_len -= data_left;
+
+		/* Headers of the segment */
+		entry = STMMAC_TX_ENTRY(priv, cur);
+		desc = priv->dma_tx + entry;
+		tso_build_hdr(skb, priv->tx_slots + entry * STMMAC_TX_SLOT_SIZE,
+			      &tso, data_left, total_len == 0);
+		priv->tx_buf[entry].type = STMMAC_TXBUF_T_SLOT;
+		desc->des2 = priv->tx_slots_phy + entry * STMMAC_TX_SLOT_SIZE;
+		priv->hw->desc->prepare_tx_desc(desc, 1, hdr_len, 1);
+		if (first == NULL)
+			first = desc;
+		else
+			priv->hw->desc->set_tx_owner(desc);
+		cur++;
+		wire_len += hdr_len + data_left;
+
+		/* Payload, straight from the skb */
+		while (data_left > 0) {
+			int size = min_t(int, tso.size, data_left);
+
+			entry = STMMAC_TX_ENTRY(priv, cur);
+			desc = priv->dma_tx + entry;
+			tx_buf = priv->tx_buf + entry;
+			tx_buf->dma = dma_map_single(priv->device, tso.data,
+						     size, DMA_TO_DEVICE);
+			if (unlikely(dma_mapping_error(priv->device,
+						       tx_buf->dma))) {
+				tx_buf->dma = 0;
+				goto dma_map_err;
+			}
+			tx_buf->len = size;
+			desc->des2 = tx_buf->dma;
+			priv->hw->desc->prepare_tx_desc(desc, 0, size, 1);
+			priv->hw->desc->set_tx_owner(desc);
+			cur++;
+
+			data_left -= size;
+			tso_build_data(skb, &tso, size);
+		}
+		stmmac_tx_close(priv, desc);
+		segs++;
+	}
+	priv->tx_buf[entry].skb = skb;
+
+	/* The whole chain must be visible before the DMA starts on it */
+	wmb();
+	priv->hw->desc->set_tx_owner(first);
+
+	u64_stats_update_begin(&priv->tx_stats.syncp);
+	u64_stats_add(&priv->tx_stats.bytes, wire_len);
+	u64_stats_inc(&priv->tx_stats.tso_frames);
+	u64_stats_add(&priv->tx_stats.tso_segs, segs);
+	u64_stats_update_end(&priv->tx_stats.syncp);
+
+	/* BQL first: the completion must never account more than queued */
+	txq = netdev_get_tx_queue(dev, 0);
+	kick = __netdev_tx_sent_queue(txq, skb->len, netdev_xmit_more());
+	trace_stmmac_xmit(dev, skb, first - priv->dma_tx, cur - priv->cur_tx,
+			  kick);
+	stmmac_tx_publish(priv, cur);
+	stmmac_tx_maybe_stop(priv);
+	/* No frame follows on a queue stopped just above */
+	if (kick || netif_xmit_stopped(txq))
+		priv->hw->dma->enable_dma_transmission(priv->ioaddr);
+
+	stmmac_tx_completion_kick(priv);
+
+	return NETDEV_TX_OK;
+
+dma_map_err:
+	stmmac_tx_unwind(priv, cur);
+	dev_kfree_skb_any(skb);
+	stmmac_stats_inc(&priv->tx_stats, map_err);
+	return NETDEV_TX_OK;
 }
 
 /**
@@ -1084,15 +2387,20 @@ static unsigned int stmmac_handle_jumbo_frames(struct sk_buff *skb,
 static netdev_tx_t stmmac_xmit(struct sk_buff *skb, struct net_device *dev)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
-	unsigned int txsize = priv->dma_tx_size;
-	unsigned int entry;
+	unsigned int entry, cur = priv->cur_tx;
 	int i, csum_insertion = 0;
 	int nfrags = skb_shinfo(skb)->nr_frags;
+	struct stmmac_tx_buffer *tx_buf;
 	struct dma_desc *desc, *first;
+	struct netdev_queue *txq;
+	bool copied = false, kick;
+
+	if (skb_is_gso(skb))
+		return stmmac_tso_xmit(skb, dev);
 
 	if (unlikely(stmmac_tx_avail(priv) < nfrags + 1)) {
 		if (!netif_queue_stopped(dev)) {
-			netif_stop_queue(dev);
+			stmmac_tx_stop(priv);
 			/* This is a hard error, log it. */
 			pr_err("%s: BUG! Tx Ring full when queue awake\n",
 				__func__);
@@ -1100,7 +2408,7 @@ static netdev_tx_t stmmac_xmit(struct sk_buff *skb, struct net_device *dev)
         return NETDEV_TX_BUSY;
 	}
 
-	entry = priv->cur_tx % txsize;
+	entry = STMMAC_TX_ENTRY(priv, cur);
 
 #ifdef STMMAC_XMIT_DEBUG
 	if ((skb->len > ETH_FRAME_LEN) || nfrags)
@@ -1122,152 +2430,720 @@ static netdev_tx_t stmmac_xmit(struct sk_buff *skb, struct net_device *dev)
 		       "\t\tn_frags: %d, ip_summed: %d\n",
 		       skb->len, skb_headlen(skb), nfrags, skb->ip_summed);
 #endif
-	priv->tx_skbuff[entry] = skb;
-	if (unlikely(skb->len >= BUF_SIZE_4KiB)) {
-		entry = stmmac_handle_jumbo_frames(skb, dev, csum_insertion);
-		desc = priv->dma_tx + entry;
-	} else {
-		unsigned int nopaged_len = skb_headlen(skb);
-		desc->des2 = dma_map_single(priv->device, skb->data,
-					nopaged_len, DMA_TO_DEVICE);
-		priv->hw->desc->prepare_tx_desc(desc, 1, nopaged_len,
+	if (skb->len <= READ_ONCE(priv->tx_copybreak)) {
+		/* Small frame: copy it, fragments included, into the coherent
+		 * slot of the descriptor. Nothing to map nor to clean from the
+		 * cache, and the skb can be released at once. */
+		skb_copy_bits(skb, 0,
+			      priv->tx_slots + entry * STMMAC_TX_SLOT_SIZE,
+			      skb->len);
+		priv->tx_buf[entry].type = STMMAC_TXBUF_T_SLOT;
+		priv->tx_buf[entry].copy_len = skb->len;
+		desc->des2 = priv->tx_slots_phy + entry * STMMAC_TX_SLOT_SIZE;
+		priv->hw->desc->prepare_tx_desc(desc, 1, skb->len,
 						csum_insertion);
+		u64_stats_update_begin(&priv->tx_stats.syncp);
+		u64_stats_inc(&priv->tx_stats.copybreak_n);
+		u64_stats_add(&priv->tx_stats.copybreak_bytes, skb->len);
+		u64_stats_update_end(&priv->tx_stats.syncp);
+		nfrags = 0;
+		copied = true;
+	} else {
+		if (unlikely(skb->len >= BUF_SIZE_4KiB)) {
+			if (stmmac_handle_jumbo_frames(skb, dev,
+						       csum_insertion, &cur))
+				goto dma_map_err;
+			entry = STMMAC_TX_ENTRY(priv, cur);
+			desc = priv->dma_tx + entry;
+		} else {
+			unsigned int nopaged_len = skb_headlen(skb);
+
+			tx_buf = priv->tx_buf + entry;
+			tx_buf->dma = dma_map_single(priv->device, skb->data,
+						     nopaged_len,
+						     DMA_TO_DEVICE);
+			if (unlikely(dma_mapping_error(priv->device,
+						       tx_buf->dma))) {
+				tx_buf->dma = 0;
+				goto dma_map_err;
+			}
+			tx_buf->len = nopaged_len;
+			desc->des2 = tx_buf->dma;
+			priv->hw->desc->prepare_tx_desc(desc, 1, nopaged_len,
+							csum_insertion);
+		}
 	}
 
 	for (i = 0; i < nfrags; i++) {
 		skb_frag_t *frag = &skb_shinfo(skb)->frags[i];
-		int len = frag->size;
+		int len = skb_frag_size(frag);
 
-		entry = (++priv->cur_tx) % txsize;
+		entry = STMMAC_TX_ENTRY(priv, ++cur);
 		desc = priv->dma_tx + entry;
 
 		TX_DBG("\t[entry %d] segment len: %d\n", entry, len);
-		desc->des2 = dma_map_page(priv->device, frag->page,
-					  frag->page_offset,
-					  len, DMA_TO_DEVICE);
-		priv->tx_skbuff[entry] = NULL;
+		tx_buf = priv->tx_buf + entry;
+		tx_buf->dma = skb_frag_dma_map(priv->device, frag, 0, len,
+					       DMA_TO_DEVICE);
+		if (unlikely(dma_mapping_error(priv->device, tx_buf->dma))) {
+			tx_buf->dma = 0;
+			goto dma_map_err;
+		}
+		tx_buf->len = len;
+		tx_buf->map_as_page = 1;
+		desc->des2 = tx_buf->dma;
 		priv->hw->desc->prepare_tx_desc(desc, 0, len, csum_insertion);
 		priv->hw->desc->set_tx_owner(desc);
 	}
 
+	/* The skb goes with the last descriptor, as in stmmac_tso_xmit: it
+	 * is released and accounted to BQL once the whole chain is out */
+	if (!copied)
+		priv->tx_buf[entry].skb = skb;
+
 	/* Interrupt on completition only for the latest segment */
-	priv->hw->desc->close_tx_desc(desc);
+	stmmac_tx_close(priv, desc);
 
-#ifdef CONFIG_STMMAC_TIMER
-	/* Clean IC while using timer */
-	if (likely(priv->tm->enable))
-		priv->hw->desc->clear_tx_ic(desc);
-#endif
-	/* To avoid raise condition */
+	/* The whole chain must be visible before the DMA starts on it */
+	dma_wmb();
 	priv->hw->desc->set_tx_owner(first);
 
-	priv->cur_tx++;
+	cur++;
 
 #ifdef STMMAC_XMIT_DEBUG
 	if (netif_msg_pktdata(priv)) {
 		pr_info("stmmac xmit: current=%d, dirty=%d, entry=%d, "
 		       "first=%p, nfrags=%d\n",
-		       (priv->cur_tx % txsize), (priv->dirty_tx % txsize),
+		       STMMAC_TX_ENTRY(priv, cur),
+		       STMMAC_TX_ENTRY(priv, priv->dirty_tx),
 		       entry, first, nfrags);
-		display_ring(priv->dma_tx, txsize);
+		display_ring(priv->dma_tx, priv->dma_tx_size);
 		pr_info(">>> frame to be transmitted: ");
 		print_pkt(skb->data, skb->len);
 	}
 #endif
-	if (unlikely(stmmac_tx_avail(priv) <= (MAX_SKB_FRAGS + 1))) {
-		TX_DBG("%s: stop transmitted packets\n", __func__);
-		netif_stop_queue(dev);
+	stmmac_stats_add(&priv->tx_stats, bytes, skb->len);
+
+	/* Ring the doorbell only once for a burst coming from the qdisc:
+	 * BQL tells whether more frames are on the way and whether the
+	 * queue has been stopped meanwhile. It is told before the frame is
+	 * published, the completion must never account more than queued;
+	 * the ring stop comes after, so it is checked again. */
+	txq = netdev_get_tx_queue(dev, 0);
+	kick = __netdev_tx_sent_queue(txq, skb->len, netdev_xmit_more());
+	trace_stmmac_xmit(dev, skb, first - priv->dma_tx, cur - priv->cur_tx,
+			  kick);
+	stmmac_tx_publish(priv, cur);
+	stmmac_tx_maybe_stop(priv);
+	if (kick || netif_xmit_stopped(txq))
+		priv->hw->dma->enable_dma_transmission(priv->ioaddr);
+
+	if (copied)
+		dev_consume_skb_any(skb);
+
+	stmmac_tx_completion_kick(priv);
+
+	return NETDEV_TX_OK;
+
+dma_map_err:
+	stmmac_tx_unwind(priv, cur);
+	dev_kfree_skb_any(skb);
+	stmmac_stats_inc(&priv->tx_stats, map_err);
+	return NETDEV_TX_OK;
+}
+
+/**
+ * stmmac_xdp_xmit_frame - queue an XDP frame on the TX ring
+ * @priv: private driver structure
+ * @xdpf: the frame
+ * @dma_map: true for the frames of ndo_xdp_xmit and of the other
+ *	     controller; false for XDP_TX, whose frame still sits in one of
+ *	     our RX pages
+ * Description: the caller holds the TX queue lock and rings the doorbell.
+ * The room for the longest chain is always left to stmmac_xmit, so the XDP
+ * traffic cannot fill the ring while the queue is awake.
+ * Return value: 0 on success, a negative errno when the frame is not queued.
+ */
+static int stmmac_xdp_xmit_frame(struct stmmac_priv *priv,
+				 struct xdp_frame *xdpf, bool dma_map)
+{
+	unsigned int entry = STMMAC_TX_ENTRY(priv, priv->cur_tx);
+	struct stmmac_tx_buffer *tx_buf = priv->tx_buf + entry;
+	struct dma_desc *desc = priv->dma_tx + entry;
+	dma_addr_t dma;
+
+	if (unlikely(stmmac_tx_avail(priv) <= STMMAC_TX_MAX_DESCS(priv)))
+		return -ENOSPC;
+
+	if (dma_map) {
+		dma = dma_map_single(priv->device, xdpf->data, xdpf->len,
+				     DMA_TO_DEVICE);
+		if (unlikely(dma_mapping_error(priv->device, dma)))
+			return -ENOMEM;
+		tx_buf->type = STMMAC_TXBUF_T_XDP_NDO;
+		tx_buf->dma = dma;
+		tx_buf->len = xdpf->len;
+	} else {
+		struct page *page = virt_to_page(xdpf->data);
+
+		dma = page_pool_get_dma_addr(page) +
+		      (xdpf->data - page_address(page));
+		dma_sync_single_for_device(priv->device, dma, xdpf->len,
+					   DMA_BIDIRECTIONAL);
+		tx_buf->type = STMMAC_TXBUF_T_XDP_TX;
 	}
+	tx_buf->xdpf = xdpf;
+
+	desc->des2 = dma;
+	priv->hw->desc->prepare_tx_desc(desc, 1, xdpf->len, 0);
+	stmmac_tx_close(priv, desc);
+	/* The descriptor must be complete before the OWN bit */
+	wmb();
+	priv->hw->desc->set_tx_owner(desc);
+
+	stmmac_tx_publish(priv, priv->cur_tx + 1);
+	u64_stats_update_begin(&priv->tx_stats.syncp);
+	u64_stats_add(&priv->tx_stats.bytes, xdpf->len);
+	u64_stats_inc(&priv->tx_stats.xdp_xmit);
+	u64_stats_update_end(&priv->tx_stats.syncp);
+
+	return 0;
+}
+
+/* XDP_TX: the frame goes back out from the RX NAPI. In zero-copy mode the
+ * conversion copies the UMEM frame into a new page and releases it, so the
+ * copy is dropped here when it cannot be queued. */
+static int stmmac_xdp_xmit_back(struct stmmac_priv *priv,
+				struct xdp_buff *xdp)
+{
+	struct xdp_frame *xdpf = xdp_convert_buff_to_frame(xdp);
+	struct netdev_queue *nq = netdev_get_tx_queue(priv->dev, 0);
+	bool zc = (priv->xsk_pool != NULL);
+	int ret;
 
-	dev->stats.tx_bytes += skb->len;
+	if (unlikely(!xdpf))
+		return -EOVERFLOW;
 
-	priv->hw->dma->enable_dma_transmission(priv->ioaddr);
+	__netif_tx_lock(nq, smp_processor_id());
+	/* The stack is not transmitting: keep the TX watchdog quiet */
+	txq_trans_cond_update(nq);
+	ret = stmmac_xdp_xmit_frame(priv, xdpf, zc);
+	__netif_tx_unlock(nq);
 
-#ifdef CONFIG_SILAN_GMAC_TX_POSTCHK
-    if (NAPI_OFF ==  priv->napi_state) {
-        stmmac_disable_irq(priv);
-        napi_schedule(&priv->napi);
-        priv->napi_state = NAPI_ON;
-    }
+	if (unlikely(ret) && zc) {
+		xdp_return_frame(xdpf);
+		stmmac_stats_inc(&priv->rx_stats, xdp_drop);
+		ret = 0;
+	}
+	return ret;
+}
+
+/**
+ * stmmac_xsk_xmit - send the frames of the AF_XDP TX ring
+ * @priv: private driver structure
+ * @budget: maximum number of frames
+ * Description: the UMEM frames are posted straight to the descriptors and
+ * released by the TX completion. The stack shares the ring, so this runs
+ * under the TX queue lock.
+ * Return value: true when the AF_XDP TX ring has been drained.
+ */
+static bool stmmac_xsk_xmit(struct stmmac_priv *priv, int budget)
+{
+	struct xsk_buff_pool *pool = priv->xsk_pool;
+	struct netdev_queue *nq = netdev_get_tx_queue(priv->dev, 0);
+	struct xdp_desc xdp_desc;
+	unsigned int queued = 0, bytes = 0;
+	bool drained = true;
+
+	__netif_tx_lock(nq, smp_processor_id());
+	txq_trans_cond_update(nq);
+	for (; budget > 0; budget--) {
+		unsigned int entry = STMMAC_TX_ENTRY(priv, priv->cur_tx);
+		struct dma_desc *desc = priv->dma_tx + entry;
+		dma_addr_t dma;
+
+		if (unlikely((stmmac_tx_avail(priv) <=
+			      STMMAC_TX_MAX_DESCS(priv)) ||
+			     !netif_carrier_ok(priv->dev))) {
+			drained = false;
+			break;
+		}
+		if (!xsk_tx_peek_desc(pool, &xdp_desc))
+			break;
+
+		dma = xsk_buff_raw_get_dma(pool, xdp_desc.addr);
+		xsk_buff_raw_dma_sync_for_device(pool, dma, xdp_desc.len);
+
+		priv->tx_buf[entry].type = STMMAC_TXBUF_T_XSK_TX;
+
+		desc->des2 = dma;
+		priv->hw->desc->prepare_tx_desc(desc, 1, xdp_desc.len, 0);
+		stmmac_tx_close(priv, desc);
+		wmb();
+		priv->hw->desc->set_tx_owner(desc);
+
+		stmmac_tx_publish(priv, priv->cur_tx + 1);
+		bytes += xdp_desc.len;
+		queued++;
+	}
+	if (!budget)
+		drained = false;
+
+	if (queued) {
+		priv->hw->dma->enable_dma_transmission(priv->ioaddr);
+		xsk_tx_release(pool);
+		stmmac_tx_completion_kick(priv);
+		u64_stats_update_begin(&priv->tx_stats.syncp);
+		u64_stats_add(&priv->tx_stats.bytes, bytes);
+		u64_stats_add(&priv->tx_stats.xsk_xmit, queued);
+		u64_stats_update_end(&priv->tx_stats.syncp);
+	}
+	__netif_tx_unlock(nq);
+
+	return drained;
+}
+
+/**
+ * stmmac_rx_run_xdp - run the XDP program on a received frame
+ * @priv: private driver structure
+ * @prog: the XDP program
+ * @xdp: the frame
+ * Return value: STMMAC_XDP_PASS when the frame goes up to the stack,
+ * STMMAC_XDP_CONSUMED when it has to be dropped; after STMMAC_XDP_TX and
+ * STMMAC_XDP_REDIRECT the buffer does not belong to the RX ring anymore.
+ */
+static int stmmac_rx_run_xdp(struct stmmac_priv *priv, struct bpf_prog *prog,
+			     struct xdp_buff *xdp)
+{
+	u32 act = bpf_prog_run_xdp(prog, xdp);
+
+	switch (act) {
+	case XDP_PASS:
+		return STMMAC_XDP_PASS;
+	case XDP_TX:
+		if (likely(!stmmac_xdp_xmit_back(priv, xdp))) {
+			stmmac_stats_inc(&priv->rx_stats, xdp_tx);
+			return STMMAC_XDP_TX;
+		}
+		break;
+	case XDP_REDIRECT:
+		if (likely(!xdp_do_redirect(priv->dev, xdp, prog))) {
+			stmmac_stats_inc(&priv->rx_stats, xdp_redirect);
+			return STMMAC_XDP_REDIRECT;
+		}
+		break;
+	default:
+		bpf_warn_invalid_xdp_action(priv->dev, prog, act);
+		fallthrough;
+	case XDP_ABORTED:
+		trace_xdp_exception(priv->dev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		break;
+	}
+	stmmac_stats_inc(&priv->rx_stats, xdp_drop);
+	return STMMAC_XDP_CONSUMED;
+}
+
+#ifdef CONFIG_SILAN_GMAC_FWD
+/**
+ * stmmac_fwd_frame - forward a received frame to the other controller
+ * @priv: private driver structure of the receiving controller
+ * @va: start of the RX buffer
+ * @offset: offset of the frame in the buffer
+ * @len: frame length
+ * Description: the source station is learnt first. A unicast frame for a
+ * station learnt on the other port is queued on the TX ring of the peer
+ * like an ndo_xdp_xmit frame: our page pool mapping belongs to our device,
+ * so the peer maps the frame itself, and its completion gives the page back
+ * to our page pool. The caller rings the doorbell of the peer.
+ * Return value: the peer when the buffer now belongs to its TX ring, NULL
+ * when the frame goes to the stack.
+ */
+static struct stmmac_priv *stmmac_fwd_frame(struct stmmac_priv *priv,
+					    void *va, unsigned int offset,
+					    unsigned int len)
+{
+	struct ethhdr *eth = va + offset;
+	int port = stmmac_fwd_port(priv);
+	struct stmmac_priv *peer;
+	struct netdev_queue *nq;
+	struct xdp_frame *xdpf;
+	struct xdp_buff xdp;
+	u16 vid = 0;
+	int ret;
+
+	if (unlikely(len < ETH_HLEN))
+		return NULL;
+	if ((eth->h_proto == htons(ETH_P_8021Q)) && (len >= VLAN_ETH_HLEN))
+		vid = ntohs(((struct vlan_ethhdr *)eth)->h_vlan_TCI) &
+		      VLAN_VID_MASK;
+
+	stmmac_fwd_learn(port, eth->h_source, vid);
+
+	if (!is_unicast_ether_addr(eth->h_dest) ||
+	    ether_addr_equal(eth->h_dest, priv->dev->dev_addr))
+		return NULL;
+	if (stmmac_fwd_lookup(eth->h_dest, vid) != !port)
+		return NULL;
+
+	peer = stmmac_fwd_peer(priv);
+	if (!peer || !netif_running(peer->dev) ||
+	    !netif_carrier_ok(peer->dev) ||
+	    (len > peer->dev->mtu + VLAN_ETH_HLEN))
+		return NULL;
+
+	xdp_init_buff(&xdp, priv->rx_truesize, &priv->xdp_rxq);
+	xdp_prepare_buff(&xdp, va, offset, len, false);
+	xdpf = xdp_convert_buff_to_frame(&xdp);
+	if (unlikely(!xdpf))
+		return NULL;
+
+	nq = netdev_get_tx_queue(peer->dev, 0);
+	__netif_tx_lock(nq, smp_processor_id());
+	/* The peer may be rebuilding its rings (see stmmac_quiesce) */
+	if (likely(netif_device_present(peer->dev))) {
+		txq_trans_cond_update(nq);
+		ret = stmmac_xdp_xmit_frame(peer, xdpf, true);
+	} else
+		ret = -ENETDOWN;
+	__netif_tx_unlock(nq);
+
+	return ret ? NULL : peer;
+}
 #endif
 
-	return NETDEV_TX_OK;
+/**
+ * stmmac_rx_sync_len - length of a received buffer to sync for the CPU
+ * @priv: private driver structure
+ * @len: number of bytes written by the DMA (FCS included)
+ * Description: unmapping or syncing the whole buffer invalidates up to
+ * dma_buf_sz bytes from the cache for each frame, even for a 64 bytes ACK.
+ * In partial sync mode only the lines the DMA has actually written are
+ * invalidated.
+ */
+static inline unsigned int stmmac_rx_sync_len(struct stmmac_priv *priv,
+					      unsigned int len)
+{
+	if (likely(priv->priv_flags & STMMAC_PRIV_FLAG_RX_PARTIAL_SYNC)) {
+		stmmac_stats_add(&priv->rx_stats, sync_saved_bytes,
+				 priv->dma_buf_sz - len);
+		return len;
+	}
+	return priv->dma_buf_sz;
 }
 
+/**
+ * stmmac_rx_reuse_buffer - give a buffer back to the DMA as it is
+ * @priv: private driver structure
+ * @entry: index of the RX descriptor
+ * @len: number of bytes synced for the CPU
+ * Description: the buffer stays attached to its descriptor and mapped; only
+ * the lines touched by the CPU are handed back to the device.
+ */
+static inline void stmmac_rx_reuse_buffer(struct stmmac_priv *priv,
+					  unsigned int entry, unsigned int len)
+{
+	dma_sync_single_for_device(priv->device, priv->rx_buf[entry].dma,
+				   len, priv->rx_dma_dir);
+}
+
+/**
+ * stmmac_rx_refill - give the processed RX descriptors back to the DMA
+ * @priv: private driver structure
+ * Description: in cacheable mode the descriptors go back a whole cache line
+ * at a time, once the CPU owns all of them: writing the line back then
+ * cannot overwrite the status of a descriptor the DMA has just closed.
+ * The line is written back even when a buffer is missing, so it is never
+ * left dirty.
+ */
 static inline void stmmac_rx_refill(struct stmmac_priv *priv)
 {
-	unsigned int rxsize = priv->dma_rx_size;
-	int bfsize = priv->dma_buf_sz;
 	struct dma_desc *p = priv->dma_rx;
+	bool cached = stmmac_rx_desc_cached(priv);
+	unsigned int step = cached ? STMMAC_RX_DESC_PER_LINE : 1;
+	unsigned int dirty = priv->dirty_rx;
+
+	while (priv->cur_rx - priv->dirty_rx >= step) {
+		unsigned int first = STMMAC_RX_ENTRY(priv, priv->dirty_rx);
+		unsigned int i, entry;
+		bool full = true;
+
+		for (i = 0; i < step; i++) {
+			entry = first + i;
+			if (likely((priv->rx_buf[entry].page == NULL) &&
+				   (priv->rx_buf[entry].xdp == NULL))) {
+				if (unlikely(stmmac_alloc_rx_buffer(priv,
+						entry, GFP_ATOMIC))) {
+					full = false;
+					break;
+				}
 
-	for (; priv->cur_rx - priv->dirty_rx > 0; priv->dirty_rx++) {
-		unsigned int entry = priv->dirty_rx % rxsize;
-		if (likely(priv->rx_skbuff[entry] == NULL)) {
-			struct sk_buff *skb;
+				RX_DBG(KERN_INFO "\trefill entry #%d\n",
+				       entry);
+			}
+		}
+		for (i = 0; full && (i < step); i++) {
+			entry = first + i;
+			priv->hw->desc->set_rx_ic(p + entry,
+						  stmmac_rx_ic(priv, entry));
+			/* The buffer address must be visible before the OWN
+			 * bit; the write back of a cached line orders it */
+			if (!cached)
+				wmb();
+			priv->hw->desc->set_rx_owner(p + entry);
+		}
+		if (cached)
+			dma_sync_single_range_for_device(priv->device,
+					priv->dma_rx_phy,
+					first * sizeof(struct dma_desc),
+					L1_CACHE_BYTES, DMA_BIDIRECTIONAL);
+		if (!full)
+			break;
+		priv->dirty_rx += step;
+	}
+	trace_stmmac_rx_refill(priv->dev, priv->dirty_rx - dirty,
+			       priv->cur_rx - priv->dirty_rx);
+
+	/* Short of UMEM frames: user space has to kick us after filling */
+	if (priv->xsk_pool && xsk_uses_need_wakeup(priv->xsk_pool)) {
+		if (priv->cur_rx != priv->dirty_rx)
+			xsk_set_rx_need_wakeup(priv->xsk_pool);
+		else
+			xsk_clear_rx_need_wakeup(priv->xsk_pool);
+	}
+}
 
-			skb = __skb_dequeue(&priv->rx_recycle);
-			if (skb == NULL)
-				skb = netdev_alloc_skb_ip_align(priv->dev,
-								bfsize);
+/* Hand a received frame to the stack */
+static inline void stmmac_rx_skb(struct stmmac_priv *priv,
+				 struct sk_buff *skb, int status)
+{
+	skb->protocol = eth_type_trans(skb, priv->dev);
 
-			if (unlikely(skb == NULL))
-				break;
+	if (unlikely(status == csum_none)) {
+		/* always for the old mac 10/100 */
+		skb_checksum_none_assert(skb);
+		netif_receive_skb(skb);
+	} else {
+		skb->ip_summed = CHECKSUM_UNNECESSARY;
+		napi_gro_receive(&priv->napi, skb);
+	}
+}
+
+/**
+ * stmmac_rx_scatter - gather a frame spanning several RX buffers
+ * @priv: private driver structure
+ * @entry: index of the RX descriptor
+ * @p: RX descriptor
+ * @status: reception status, only set when the frame is complete
+ * Description: the first buffer becomes the linear part of the skb, the
+ * next ones are attached as page fragments. The skb under assembly is kept
+ * in priv->rx_skb, so a frame may straddle two NAPI polls. Only the last
+ * descriptor carries the status and the length of the whole frame (FCS
+ * included): the other buffers are full, dma_buf_sz bytes as programmed
+ * in the descriptors (see stmmac_rx_buf_size). A chain that is broken, too long
+ * or seen by an XDP program (which needs linear frames) is dropped.
+ * Return value: the skb when its last descriptor has been processed.
+ */
+static struct sk_buff *stmmac_rx_scatter(struct stmmac_priv *priv,
+					 unsigned int entry,
+					 struct dma_desc *p, int *status)
+{
+	struct stmmac_rx_buffer *buf = priv->rx_buf + entry;
+	struct sk_buff *skb = priv->rx_skb;
+	int last = priv->hw->desc->get_rx_ls(p);
+	int len = priv->dma_buf_sz;
+	void *va;
+
+	if (priv->hw->desc->get_rx_fs(p)) {
+		/* The previous chain never got its last descriptor */
+		if (unlikely(skb || priv->rx_skb_drop)) {
+			priv->dev->stats.rx_length_errors++;
+			priv->dev->stats.rx_errors++;
+			if (skb)
+				dev_kfree_skb_any(skb);
+			skb = NULL;
+		}
+		priv->rx_skb_drop = !!READ_ONCE(priv->xdp_prog);
+	} else if (unlikely(!skb))
+		/* Middle of a frame whose start has been dropped */
+		priv->rx_skb_drop = true;
+
+	if (last) {
+		*status = priv->hw->desc->rx_status(&priv->dev->stats,
+						    &priv->xstats, p);
+		len = priv->hw->desc->get_rx_frame_len(p) -
+		      (skb ? skb->len : 0);
+		if (unlikely(*status == discard_frame))
+			priv->rx_skb_drop = true;
+		else if (unlikely((len <= 0) || (len > priv->dma_buf_sz))) {
+			priv->dev->stats.rx_length_errors++;
+			priv->rx_skb_drop = true;
+		}
+	}
 
-			priv->rx_skbuff[entry] = skb;
-			priv->rx_skbuff_dma[entry] =
-			    dma_map_single(priv->device, skb->data, bfsize,
-					   DMA_FROM_DEVICE);
+	if (unlikely(!priv->rx_skb_drop && !buf->page)) {
+		pr_err("%s: Inconsistent Rx descriptor chain\n",
+		       priv->dev->name);
+		priv->rx_skb_drop = true;
+	}
 
-			(p + entry)->des2 = priv->rx_skbuff_dma[entry];
-			if (unlikely(priv->plat->has_gmac)) {
-				if (bfsize >= BUF_SIZE_8KiB)
-					(p + entry)->des3 =
-					    (p + entry)->des2 + BUF_SIZE_8KiB;
+	/* The buffer of a dropped chain is left untouched by the CPU, it is
+	 * re-armed as it is */
+	if (!priv->rx_skb_drop) {
+		dma_sync_single_for_cpu(priv->device,
+					priv->rx_buf[entry].dma,
+					stmmac_rx_sync_len(priv, len),
+					priv->rx_dma_dir);
+		va = page_address(buf->page) + buf->page_offset;
+		if (!skb) {
+			skb = build_skb(va, priv->rx_truesize);
+			if (likely(skb)) {
+				skb_reserve(skb, priv->rx_headroom);
+				skb_put(skb, len);
+				skb_mark_for_recycle(skb);
+				buf->page = NULL;
+			} else {
+				stmmac_rx_reuse_buffer(priv, entry, len);
+				priv->dev->stats.rx_dropped++;
+				priv->rx_skb_drop = true;
 			}
-			RX_DBG(KERN_INFO "\trefill entry #%d\n", entry);
+		} else if (likely(skb_shinfo(skb)->nr_frags < MAX_SKB_FRAGS)) {
+			skb_add_rx_frag(skb, skb_shinfo(skb)->nr_frags,
+					buf->page,
+					buf->page_offset + priv->rx_headroom,
+					len, priv->rx_truesize);
+			buf->page = NULL;
+		} else {
+			stmmac_rx_reuse_buffer(priv, entry, len);
+			priv->dev->stats.rx_length_errors++;
+			priv->rx_skb_drop = true;
 		}
-		priv->hw->desc->set_rx_owner(p + entry);
 	}
+
+	if (unlikely(priv->rx_skb_drop) && skb) {
+		dev_kfree_skb_any(skb);
+		skb = NULL;
+	}
+
+	if (!last) {
+		priv->rx_skb = skb;
+		return NULL;
+	}
+
+	priv->rx_skb = NULL;
+	if (unlikely(priv->rx_skb_drop)) {
+		priv->rx_skb_drop = false;
+		priv->dev->stats.rx_errors++;
+		return NULL;
+	}
+
+	/* The FCS may straddle the last two buffers */
+	if (likely(*status != llc_snap))
+		pskb_trim(skb, skb->len - ETH_FCS_LEN);
+	stmmac_stats_inc(&priv->rx_stats, scatter_n);
+
+	return skb;
+}
+
+/* Packets and bytes are accounted once per NAPI cycle */
+static inline void stmmac_rx_stats_update(struct stmmac_priv *priv,
+					  unsigned int count,
+					  unsigned int packets,
+					  unsigned int bytes)
+{
+	u64_stats_update_begin(&priv->rx_stats.syncp);
+	u64_stats_add(&priv->rx_stats.pkt_n, count);
+	u64_stats_add(&priv->rx_stats.packets, packets);
+	u64_stats_add(&priv->rx_stats.bytes, bytes);
+	u64_stats_update_end(&priv->rx_stats.syncp);
+}
+
+/* One doorbell and one flush for the whole NAPI cycle */
+static inline void stmmac_rx_xdp_finalize(struct stmmac_priv *priv,
+					  int xdp_status)
+{
+	if (xdp_status & STMMAC_XDP_TX) {
+		priv->hw->dma->enable_dma_transmission(priv->ioaddr);
+		stmmac_tx_completion_kick(priv);
+	}
+	if (xdp_status & STMMAC_XDP_REDIRECT)
+		xdp_do_flush();
 }
 
-static int stmmac_rx(struct stmmac_priv *priv, int limit)
+static __always_inline int __stmmac_rx(struct stmmac_priv *priv, int limit,
+				       const bool enh)
 {
-	unsigned int rxsize = priv->dma_rx_size;
-	unsigned int entry = priv->cur_rx % rxsize;
+	unsigned int entry = STMMAC_RX_ENTRY(priv, priv->cur_rx);
 	unsigned int next_entry;
 	unsigned int count = 0;
 	struct dma_desc *p = priv->dma_rx + entry;
 	struct dma_desc *p_next;
+	struct bpf_prog *prog = READ_ONCE(priv->xdp_prog);
+	int xdp_status = 0;
+	unsigned int rx_packets = 0, rx_bytes = 0;
+	u32 rdes0;
+#ifdef CONFIG_SILAN_GMAC_FWD
+	struct stmmac_priv *fwd_peer = NULL;
+#endif
 
 #ifdef STMMAC_RX_DEBUG
 	if (netif_msg_hw(priv)) {
 		pr_debug(">>> stmmac_rx: descriptor ring:\n");
-		display_ring(priv->dma_rx, rxsize);
+		display_ring(priv->dma_rx, priv->dma_rx_size);
 	}
 #endif
 	count = 0;
-	while (!priv->hw->desc->get_rx_owner(p)) {
+	stmmac_rx_desc_sync_line(priv, entry);
+	while (!((rdes0 = stmmac_desc_word(p, 0)) & RDES0_OWN)) {
 		int status;
 
 		if (count >= limit)
 			break;
 
 		count++;
+		trace_stmmac_rx_frame(priv->dev, entry, rdes0);
 
-		next_entry = (++priv->cur_rx) % rxsize;
+		next_entry = STMMAC_RX_ENTRY(priv, ++priv->cur_rx);
 		p_next = priv->dma_rx + next_entry;
 		prefetch(p_next);
 
+		if (unlikely(priv->rx_skb || priv->rx_skb_drop ||
+			     (rdes0 & (RDES0_FS | RDES0_LS)) !=
+			     (RDES0_FS | RDES0_LS))) {
+			struct sk_buff *skb;
+			unsigned int len;
+
+			skb = stmmac_rx_scatter(priv, entry, p, &status);
+			if (skb) {
+				len = skb->len;
+				stmmac_rx_skb(priv, skb, status);
+				rx_packets++;
+				rx_bytes += len;
+			}
+			goto next_frame;
+		}
+
 		/* read the status of the incoming frame */
-		status = (priv->hw->desc->rx_status(&priv->dev->stats,
-						    &priv->xstats, p));
+		status = stmmac_desc_rx_status(priv, p, rdes0, enh);
 		if (unlikely(status == discard_frame))
 			priv->dev->stats.rx_errors++;
 		else {
+			struct stmmac_rx_buffer *buf = priv->rx_buf + entry;
 			struct sk_buff *skb;
+			unsigned int sync_len, offset;
+			struct xdp_buff xdp;
+			void *va;
 			int frame_len;
 
-			frame_len = priv->hw->desc->get_rx_frame_len(p);
+			frame_len = stmmac_rdes0_frame_len(rdes0);
+			if (unlikely(frame_len > priv->dma_buf_sz)) {
+				/* The frame spanned more than one buffer */
+				priv->dev->stats.rx_length_errors++;
+				priv->dev->stats.rx_errors++;
+				goto next_frame;
+			}
+			sync_len = stmmac_rx_sync_len(priv, frame_len);
 			/* ACS is set; GMAC core strips PAD/FCS for IEEE 802.3
 			 * Type frames (LLC/LLC-SNAP) */
 			if (unlikely(status != llc_snap))
@@ -1281,75 +3157,314 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit)
 				pr_debug("\tdesc: %p [entry %d] buff=0x%x\n",
 					p, entry, p->des2);
 #endif
-			skb = priv->rx_skbuff[entry];
-			if (unlikely(!skb)) {
+			if (unlikely(!buf->page)) {
 				pr_err("%s: Inconsistent Rx descriptor chain\n",
 					priv->dev->name);
 				priv->dev->stats.rx_dropped++;
 				break;
 			}
-			prefetch(skb->data - NET_IP_ALIGN);
-			priv->rx_skbuff[entry] = NULL;
+			dma_sync_single_for_cpu(priv->device,
+						priv->rx_buf[entry].dma,
+						sync_len, priv->rx_dma_dir);
+			va = page_address(buf->page) + buf->page_offset;
+			offset = priv->rx_headroom;
+			prefetch(va + offset);
+
+			if (prog) {
+				int res;
+
+				xdp_init_buff(&xdp, priv->rx_truesize,
+					      &priv->xdp_rxq);
+				xdp_prepare_buff(&xdp, va, offset, frame_len,
+						 false);
+				res = stmmac_rx_run_xdp(priv, prog, &xdp);
+
+				/* The program may have written past the
+				 * received data: hand those lines back too */
+				sync_len = max_t(int, sync_len,
+						 xdp.data_end - (va + offset));
+				if (res != STMMAC_XDP_PASS) {
+					if (res == STMMAC_XDP_CONSUMED)
+						stmmac_rx_reuse_buffer(priv,
+							entry, sync_len);
+					else
+						buf->page = NULL;
+					xdp_status |= res;
+					rx_packets++;
+					rx_bytes += frame_len;
+					goto next_frame;
+				}
+
+				/* The headers may have been moved */
+				offset = xdp.data - va;
+				frame_len = xdp.data_end - xdp.data;
+			}
+
+#ifdef CONFIG_SILAN_GMAC_FWD
+			if (priv->priv_flags & STMMAC_PRIV_FLAG_FWD) {
+				struct stmmac_priv *peer;
+
+				peer = stmmac_fwd_frame(priv, va, offset,
+							frame_len);
+				if (peer) {
+					buf->page = NULL;
+					fwd_peer = peer;
+					stmmac_stats_inc(&priv->rx_stats,
+							 fwd_n);
+					rx_packets++;
+					rx_bytes += frame_len;
+					goto next_frame;
+				}
+			}
+#endif
 
-			skb_put(skb, frame_len);
-			dma_unmap_single(priv->device,
-					 priv->rx_skbuff_dma[entry],
-					 priv->dma_buf_sz, DMA_FROM_DEVICE);
+			if (frame_len < priv->rx_copybreak) {
+				/* Small frame: copy it and leave the buffer
+				 * in place, stmmac_rx_refill re-arms it
+				 * without any new allocation */
+				skb = napi_alloc_skb(&priv->napi, frame_len);
+				if (likely(skb)) {
+					skb_put_data(skb, va + offset,
+						     frame_len);
+					stmmac_stats_inc(&priv->rx_stats,
+							 copybreak_n);
+				}
+				stmmac_rx_reuse_buffer(priv, entry, sync_len);
+			} else {
+				skb = build_skb(va, priv->rx_truesize);
+				if (likely(skb)) {
+					skb_reserve(skb, offset);
+					skb_put(skb, frame_len);
+					skb_mark_for_recycle(skb);
+					buf->page = NULL;
+				} else
+					stmmac_rx_reuse_buffer(priv, entry,
+							       sync_len);
+			}
+			if (unlikely(!skb)) {
+				priv->dev->stats.rx_dropped++;
+				goto next_frame;
+			}
 #ifdef STMMAC_RX_DEBUG
 			if (netif_msg_pktdata(priv)) {
 				pr_info(" frame received (%dbytes)", frame_len);
 				print_pkt(skb->data, frame_len);
 			}
 #endif
-			skb->protocol = eth_type_trans(skb, priv->dev);
-
-			if (unlikely(status == csum_none)) {
-				/* always for the old mac 10/100 */
-				skb_checksum_none_assert(skb);
-				netif_receive_skb(skb);
-			} else {
-				skb->ip_summed = CHECKSUM_UNNECESSARY;
-				napi_gro_receive(&priv->napi, skb);
-			}
+			stmmac_rx_skb(priv, skb, status);
 
-			priv->dev->stats.rx_packets++;
-			priv->dev->stats.rx_bytes += frame_len;
+			rx_packets++;
+			rx_bytes += frame_len;
 		}
+next_frame:
 		entry = next_entry;
 		p = p_next;	/* use prefetched values */
+		stmmac_rx_desc_next(priv, entry);
+	}
+
+	stmmac_rx_xdp_finalize(priv, xdp_status);
+#ifdef CONFIG_SILAN_GMAC_FWD
+	if (fwd_peer) {
+		fwd_peer->hw->dma->enable_dma_transmission(fwd_peer->ioaddr);
+		stmmac_tx_completion_kick(fwd_peer);
+	}
+#endif
+	stmmac_rx_refill(priv);
+
+	stmmac_rx_stats_update(priv, count, rx_packets, rx_bytes);
+	trace_stmmac_rx_poll(priv->dev, count, limit, rx_packets, rx_bytes);
+
+	return count;
+}
+
+static int stmmac_rx(struct stmmac_priv *priv, int limit)
+{
+	if (priv->plat->enh_desc)
+		return __stmmac_rx(priv, limit, true);
+	return __stmmac_rx(priv, limit, false);
+}
+
+/**
+ * __stmmac_rx_zc - reception in AF_XDP zero-copy mode
+ * @priv: private driver structure
+ * @limit: NAPI budget
+ * @enh: enhanced descriptors
+ * Description: the descriptors point straight to the UMEM frames and no skb
+ * is built for the frames the XDP program redirects to the socket. The few
+ * frames passed to the stack are copied, their UMEM frame goes back to the
+ * pool at once.
+ */
+static __always_inline int __stmmac_rx_zc(struct stmmac_priv *priv,
+					  int limit, const bool enh)
+{
+	unsigned int entry = STMMAC_RX_ENTRY(priv, priv->cur_rx);
+	struct dma_desc *p = priv->dma_rx + entry;
+	struct bpf_prog *prog = READ_ONCE(priv->xdp_prog);
+	unsigned int count = 0;
+	int xdp_status = 0;
+	unsigned int rx_packets = 0, rx_bytes = 0;
+	u32 rdes0;
+
+	stmmac_rx_desc_sync_line(priv, entry);
+	while (!((rdes0 = stmmac_desc_word(p, 0)) & RDES0_OWN)) {
+		struct stmmac_rx_buffer *buf = priv->rx_buf + entry;
+		struct xdp_buff *xdp = buf->xdp;
+		struct sk_buff *skb;
+		int status, frame_len, res;
+
+		if (count >= limit)
+			break;
+
+		count++;
+		trace_stmmac_rx_frame(priv->dev, entry, rdes0);
+
+		status = stmmac_desc_rx_status(priv, p, rdes0, enh);
+		if (unlikely(xdp == NULL)) {
+			pr_err("%s: Inconsistent Rx descriptor chain\n",
+				priv->dev->name);
+			priv->dev->stats.rx_dropped++;
+			break;
+		}
+		buf->xdp = NULL;
+		priv->cur_rx++;
+
+		/* A frame spread over several UMEM frames cannot be handed to
+		 * the socket: each piece is dropped */
+		if (unlikely((rdes0 & (RDES0_FS | RDES0_LS)) !=
+			     (RDES0_FS | RDES0_LS))) {
+			priv->dev->stats.rx_length_errors++;
+			priv->dev->stats.rx_errors++;
+			xsk_buff_free(xdp);
+			goto next_frame;
+		}
+
+		frame_len = stmmac_rdes0_frame_len(rdes0);
+		if (unlikely(status == discard_frame)) {
+			priv->dev->stats.rx_errors++;
+			xsk_buff_free(xdp);
+			goto next_frame;
+		}
+		if (unlikely(frame_len > priv->dma_buf_sz)) {
+			priv->dev->stats.rx_length_errors++;
+			priv->dev->stats.rx_errors++;
+			xsk_buff_free(xdp);
+			goto next_frame;
+		}
+		if (unlikely(status != llc_snap))
+			frame_len -= ETH_FCS_LEN;
+
+		xdp->data_end = xdp->data + frame_len;
+		xsk_buff_dma_sync_for_cpu(xdp, priv->xsk_pool);
+
+		rx_packets++;
+		rx_bytes += frame_len;
+
+		res = prog ? stmmac_rx_run_xdp(priv, prog, xdp) :
+			     STMMAC_XDP_PASS;
+		if (res == STMMAC_XDP_PASS) {
+			frame_len = xdp->data_end - xdp->data;
+			skb = napi_alloc_skb(&priv->napi, frame_len);
+			if (likely(skb))
+				skb_put_data(skb, xdp->data, frame_len);
+			xsk_buff_free(xdp);
+			if (unlikely(!skb)) {
+				priv->dev->stats.rx_dropped++;
+				goto next_frame;
+			}
+			stmmac_rx_skb(priv, skb, status);
+		} else if (res == STMMAC_XDP_CONSUMED)
+			xsk_buff_free(xdp);
+		xdp_status |= res;
+next_frame:
+		entry = STMMAC_RX_ENTRY(priv, priv->cur_rx);
+		p = priv->dma_rx + entry;
+		stmmac_rx_desc_next(priv, entry);
 	}
 
+	stmmac_rx_xdp_finalize(priv, xdp_status);
 	stmmac_rx_refill(priv);
 
-	priv->xstats.rx_pkt_n += count;
+	stmmac_rx_stats_update(priv, count, rx_packets, rx_bytes);
+	trace_stmmac_rx_poll(priv->dev, count, limit, rx_packets, rx_bytes);
 
 	return count;
 }
 
+static int stmmac_rx_zc(struct stmmac_priv *priv, int limit)
+{
+	if (priv->plat->enh_desc)
+		return __stmmac_rx_zc(priv, limit, true);
+	return __stmmac_rx_zc(priv, limit, false);
+}
+
 /**
- *  stmmac_poll - stmmac poll method (NAPI)
+ *  stmmac_poll - stmmac RX poll method (NAPI)
  *  @napi : pointer to the napi structure.
  *  @budget : maximum number of packets that the current CPU can receive from
  *	      all interfaces.
  *  Description :
  *   This function implements the the reception process.
- *   Also it runs the TX completion thread
+ *   The RX interrupt stays masked until it completes.
  */
 static int stmmac_poll(struct napi_struct *napi, int budget)
 {
 	struct stmmac_priv *priv = container_of(napi, struct stmmac_priv, napi);
 	int work_done = 0;
 
-	priv->xstats.poll_n++;
-	stmmac_tx(priv);
-	work_done = stmmac_rx(priv, budget);
+	stmmac_stats_inc(&priv->rx_stats, poll_n);
+	/* New coalescing parameters from ethtool or DIM */
+	if (unlikely(xchg(&priv->rx_coal_update, false)))
+		stmmac_rx_coalesce_write(priv);
+	stmmac_hist_rx_start(priv);
+	if (priv->xsk_pool)
+		work_done = stmmac_rx_zc(priv, budget);
+	else
+		work_done = stmmac_rx(priv, budget);
+	stmmac_hist_rx_end(priv, work_done, budget);
 
 	if (work_done < budget) {
-		napi_complete(napi);
-        stmmac_enable_irq(priv);
-#ifdef CONFIG_SILAN_GMAC_TX_POSTCHK
-        priv->napi_state = NAPI_OFF;
-#endif
+		stmmac_rx_dim_update(priv);
+		if (napi_complete_done(napi, work_done))
+			stmmac_enable_irq(priv, true, false);
+	}
+	return work_done;
+}
+
+/**
+ *  stmmac_tx_poll - stmmac TX poll method (NAPI)
+ *  @napi : pointer to the TX napi structure.
+ *  @budget : maximum number of descriptors to release.
+ *  Description :
+ *   This function runs the TX completion, independently of the reception
+ *   and with its own budget. The TX interrupt stays masked until it
+ *   completes.
+ */
+static int stmmac_tx_poll(struct napi_struct *napi, int budget)
+{
+	struct stmmac_priv *priv = container_of(napi, struct stmmac_priv,
+						tx_napi);
+	int work_done;
+
+	stmmac_stats_inc(&priv->txc_stats, poll_n);
+	stmmac_hist_tx_start(priv);
+	work_done = stmmac_tx(priv, budget);
+	stmmac_hist_tx_end(priv, work_done, budget);
+	if (priv->xsk_pool) {
+		/* Stay scheduled while the AF_XDP TX ring has frames */
+		if (!stmmac_xsk_xmit(priv, budget))
+			work_done = budget;
+		if (xsk_uses_need_wakeup(priv->xsk_pool))
+			xsk_set_tx_need_wakeup(priv->xsk_pool);
+	}
+
+	if (work_done < budget) {
+		stmmac_tx_dim_update(priv);
+		if (napi_complete_done(napi, 0))
+			stmmac_enable_irq(priv, false, true);
+		/* No TX interrupt will come for the frames still in flight */
+		if ((READ_ONCE(priv->tx_completion) != TX_COMPLETION_IRQ) &&
+		    stmmac_tx_has_work(priv))
+			stmmac_arm_tx_timer(priv);
 	}
 	return work_done;
 }
@@ -1362,7 +3477,7 @@ static int stmmac_poll(struct napi_struct *napi, int budget)
  *   netdev structure and arrange for the device to be reset to a sane state
  *   in order to transmit a new packet.
  */
-static void stmmac_tx_timeout(struct net_device *dev)
+static void stmmac_tx_timeout(struct net_device *dev, unsigned int txqueue)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
 
@@ -1370,6 +3485,39 @@ static void stmmac_tx_timeout(struct net_device *dev)
 	stmmac_tx_err(priv);
 }
 
+/**
+ *  stmmac_get_stats64
+ *  @dev : Pointer to net device structure
+ *  @stats : the statistics to fill
+ *  Description: the per packet counters are read from their u64_stats
+ *  blocks, without stopping the datapath; the error counters come from
+ *  dev->stats.
+ */
+static void stmmac_get_stats64(struct net_device *dev,
+			       struct rtnl_link_stats64 *stats)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	unsigned int start;
+
+	netdev_stats_to_stats64(stats, &dev->stats);
+
+	do {
+		start = u64_stats_fetch_begin(&priv->rx_stats.syncp);
+		stats->rx_packets = u64_stats_read(&priv->rx_stats.packets);
+		stats->rx_bytes = u64_stats_read(&priv->rx_stats.bytes);
+	} while (u64_stats_fetch_retry(&priv->rx_stats.syncp, start));
+
+	do {
+		start = u64_stats_fetch_begin(&priv->tx_stats.syncp);
+		stats->tx_bytes = u64_stats_read(&priv->tx_stats.bytes);
+	} while (u64_stats_fetch_retry(&priv->tx_stats.syncp, start));
+
+	do {
+		start = u64_stats_fetch_begin(&priv->txc_stats.syncp);
+		stats->tx_packets = u64_stats_read(&priv->txc_stats.packets);
+	} while (u64_stats_fetch_retry(&priv->txc_stats.syncp, start));
+}
+
 /* Configuration changes (passed on by ifconfig) */
 static int stmmac_config(struct net_device *dev, struct ifmap *map)
 {
@@ -1378,13 +3526,13 @@ static int stmmac_config(struct net_device *dev, struct ifmap *map)
 
 	/* Don't allow changing the I/O address */
 	if (map->base_addr != dev->base_addr) {
-		pr_warning("%s: can't change I/O address\n", dev->name);
+		pr_warn("%s: can't change I/O address\n", dev->name);
 		return -EOPNOTSUPP;
 	}
 
 	/* Don't allow changing the IRQ */
 	if (map->irq != dev->irq) {
-		pr_warning("%s: can't change IRQ number %d\n",
+		pr_warn("%s: can't change IRQ number %d\n",
 		       dev->name, dev->irq);
 		return -EOPNOTSUPP;
 	}
@@ -1418,6 +3566,8 @@ static void stmmac_multicast_list(struct net_device *dev)
  *  Description: the Maximum Transfer Unit (MTU) is used by the network layer
  *  to drive packet transmission. Ethernet has an MTU of 1500 octets
  *  (ETH_DATA_LEN). This value can be changed with ifconfig.
+ *  It can be changed while the interface is running: the rings are rebuilt
+ *  without taking the link down, see stmmac_rebuild_rings.
  *  Return value:
  *  0 on success and an appropriate (-)ve integer as defined in errno.h
  *  file on failure.
@@ -1425,12 +3575,9 @@ static void stmmac_multicast_list(struct net_device *dev)
 static int stmmac_change_mtu(struct net_device *dev, int new_mtu)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
-	int max_mtu;
-
-	if (netif_running(dev)) {
-		pr_err("%s: must be stopped to change its MTU\n", dev->name);
-		return -EBUSY;
-	}
+	struct stmmac_ring_cfg cfg;
+	int max_mtu, no_csum;
+	int ret;
 
 	if (priv->plat->has_gmac)
 		max_mtu = JUMBO_LEN;
@@ -1442,27 +3589,252 @@ static int stmmac_change_mtu(struct net_device *dev, int new_mtu)
 		return -EINVAL;
 	}
 
-	dev->mtu = new_mtu;
+	if (priv->xdp_prog && !stmmac_xdp_mtu_ok(new_mtu)) {
+		pr_err("%s: MTU %d too large for XDP\n", dev->name, new_mtu);
+		return -EINVAL;
+	}
+
+	if (priv->xsk_pool && !stmmac_xsk_mtu_ok(priv->xsk_pool, new_mtu)) {
+		pr_err("%s: MTU %d too large for the AF_XDP frames\n",
+		       dev->name, new_mtu);
+		return -EINVAL;
+	}
+
+	/* The bugged jumbo support cannot insert the checksum of oversized
+	 * frames: they are sent in threshold mode without COE */
+	no_csum = priv->plat->bugged_jumbo && (new_mtu > ETH_DATA_LEN);
+
+	/* A running interface needs new rings when the RX buffers change
+	 * size, the DMA mode is set again while it is stopped. The MAC
+	 * accepts jumbo frames anyway. */
+	if (netif_running(dev) &&
+	    ((stmmac_rx_buf_size(priv, new_mtu) != priv->dma_buf_sz) ||
+	     (no_csum != priv->no_csum_insertion))) {
+		stmmac_ring_cfg_get(priv, &cfg);
+		cfg.mtu = new_mtu;
+		cfg.no_csum = no_csum;
+		ret = stmmac_rebuild_rings(dev, &cfg);
+		if (ret < 0)
+			return ret;
+	} else {
+		priv->no_csum_insertion = no_csum;
+		dev->mtu = new_mtu;
+	}
 	netdev_update_features(dev);
 
 	return 0;
 }
 
-static u32 stmmac_fix_features(struct net_device *dev, u32 features)
+/**
+ * stmmac_xdp_setup - attach/detach the XDP program
+ * @dev: device pointer
+ * @prog: the new program, NULL to detach it
+ * @extack: netlink extended ack
+ * Description: the RX buffers need a different headroom and mapping with
+ * and without a program, so the rings of a running interface are rebuilt
+ * when XDP is turned on or off (see stmmac_rebuild_rings), the link stays
+ * up. Replacing a program with another one is done on the fly.
+ */
+static int stmmac_xdp_setup(struct net_device *dev, struct bpf_prog *prog,
+			    struct netlink_ext_ack *extack)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	struct bpf_prog *old = priv->xdp_prog;
+	struct stmmac_ring_cfg cfg;
+	int ret;
+
+	if (prog && !stmmac_xdp_mtu_ok(dev->mtu)) {
+		NL_SET_ERR_MSG_MOD(extack, "MTU too large for XDP");
+		return -EOPNOTSUPP;
+	}
+
+	if (netif_running(dev) && (!old != !prog)) {
+		stmmac_ring_cfg_get(priv, &cfg);
+		cfg.prog = prog;
+		/* On error the previous program is back in place, the
+		 * caller drops the new one */
+		ret = stmmac_rebuild_rings(dev, &cfg);
+		if (ret < 0) {
+			NL_SET_ERR_MSG_MOD(extack, "cannot rebuild the rings");
+			return ret;
+		}
+	} else {
+		WRITE_ONCE(priv->xdp_prog, prog);
+	}
+
+	if (old)
+		bpf_prog_put(old);
+
+	return 0;
+}
+
+/**
+ * stmmac_xsk_pool_setup - bind/unbind an AF_XDP buffer pool
+ * @dev: device pointer
+ * @pool: the UMEM pool, NULL to go back to the page pool
+ * @qid: queue the socket is bound to
+ * Description: the GMAC has a single pair of rings, those of a running
+ * interface are rebuilt on top of the UMEM frames (or of the page pool
+ * again) without taking the link down, see stmmac_rebuild_rings. The new
+ * pool is mapped before and the old one unmapped once the rings have left
+ * it: on error the old pool is still in use and the new one is unmapped.
+ */
+static int stmmac_xsk_pool_setup(struct net_device *dev,
+				 struct xsk_buff_pool *pool, u16 qid)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	struct xsk_buff_pool *old = priv->xsk_pool;
+	struct stmmac_ring_cfg cfg;
+	int ret;
+
+	if (qid != 0)
+		return -EINVAL;
+	if (pool && old)
+		return -EBUSY;
+	if (!pool && !old)
+		return -EINVAL;
+
+	if (pool && !stmmac_xsk_mtu_ok(pool, dev->mtu)) {
+		pr_err("%s: MTU %d too large for the AF_XDP frames\n",
+		       dev->name, dev->mtu);
+		return -EINVAL;
+	}
+
+	if (pool) {
+		ret = xsk_pool_dma_map(pool, priv->device, 0);
+		if (ret)
+			return ret;
+	}
+
+	if (netif_running(dev)) {
+		stmmac_ring_cfg_get(priv, &cfg);
+		cfg.pool = pool;
+		ret = stmmac_rebuild_rings(dev, &cfg);
+		if (ret < 0) {
+			if (pool)
+				xsk_pool_dma_unmap(pool, 0);
+			return ret;
+		}
+	} else {
+		priv->xsk_pool = pool;
+	}
+
+	if (old)
+		xsk_pool_dma_unmap(old, 0);
+
+	return 0;
+}
+
+static int stmmac_bpf(struct net_device *dev, struct netdev_bpf *bpf)
+{
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		return stmmac_xdp_setup(dev, bpf->prog, bpf->extack);
+	case XDP_SETUP_XSK_POOL:
+		return stmmac_xsk_pool_setup(dev, bpf->xsk.pool,
+					     bpf->xsk.queue_id);
+	default:
+		return -EINVAL;
+	}
+}
+
+/**
+ * stmmac_xdp_xmit - ndo_xdp_xmit entry point
+ * @dev: device pointer
+ * @num_frames: number of frames
+ * @frames: frames redirected to this interface
+ * @flags: XDP_XMIT_FLUSH rings the doorbell
+ * Return value: the number of frames queued, the core frees the others.
+ */
+static int stmmac_xdp_xmit(struct net_device *dev, int num_frames,
+			   struct xdp_frame **frames, u32 flags)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+	struct netdev_queue *nq = netdev_get_tx_queue(dev, 0);
+	int i, nxmit = 0;
+
+	if (unlikely(!netif_running(dev) || !netif_carrier_ok(dev)))
+		return -ENETDOWN;
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	__netif_tx_lock(nq, smp_processor_id());
+	/* The rings are being rebuilt (see stmmac_quiesce) */
+	if (unlikely(!netif_device_present(dev))) {
+		__netif_tx_unlock(nq);
+		return -ENETDOWN;
+	}
+	txq_trans_cond_update(nq);
+	for (i = 0; i < num_frames; i++) {
+		if (stmmac_xdp_xmit_frame(priv, frames[i], true))
+			break;
+		nxmit++;
+	}
+	if (flags & XDP_XMIT_FLUSH) {
+		priv->hw->dma->enable_dma_transmission(priv->ioaddr);
+		stmmac_tx_completion_kick(priv);
+	}
+	__netif_tx_unlock(nq);
+
+	return nxmit;
+}
+
+/* AF_XDP wakeup: user space has filled the fill ring or the TX ring */
+static int stmmac_xsk_wakeup(struct net_device *dev, u32 queue, u32 flags)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	if (unlikely(!netif_running(dev) || !netif_carrier_ok(dev)))
+		return -ENETDOWN;
+	/* The rings are being rebuilt (see stmmac_quiesce) */
+	if (unlikely(!netif_device_present(dev)))
+		return -ENETDOWN;
+	if ((queue != 0) || !priv->xsk_pool)
+		return -EINVAL;
+
+	if ((flags & XDP_WAKEUP_RX) &&
+	    !napi_if_scheduled_mark_missed(&priv->napi))
+		stmmac_schedule_rx(priv);
+	if ((flags & XDP_WAKEUP_TX) &&
+	    !napi_if_scheduled_mark_missed(&priv->tx_napi))
+		stmmac_schedule_tx(priv);
+
+	return 0;
+}
+
+/* The software TSO takes the GSO skbs that fit the room kept free while the
+ * queue is awake and whose segments fit a descriptor buffer; the stack
+ * segments the others */
+static netdev_features_t stmmac_features_check(struct sk_buff *skb,
+					       struct net_device *dev,
+					       netdev_features_t features)
+{
+	struct stmmac_priv *priv = netdev_priv(dev);
+
+	if (skb_is_gso(skb) &&
+	    ((tso_count_descs(skb) > STMMAC_TX_MAX_DESCS(priv)) ||
+	     (skb_shinfo(skb)->gso_size > ETH_DATA_LEN)))
+		features &= ~NETIF_F_GSO_MASK;
+
+	return features;
+}
+
+static netdev_features_t stmmac_fix_features(struct net_device *dev,
+					     netdev_features_t features)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
 
 	if (!priv->rx_coe)
 		features &= ~NETIF_F_RXCSUM;
 	if (!priv->plat->tx_coe)
-		features &= ~NETIF_F_ALL_CSUM;
+		features &= ~NETIF_F_CSUM_MASK;
 
 	/* Some GMAC devices have a bugged Jumbo frame support that
 	 * needs to have the Tx COE disabled for oversized frames
 	 * (due to limited buffer sizes). In this case we disable
 	 * the TX csum insertionin the TDES and not use SF. */
 	if (priv->plat->bugged_jumbo && (dev->mtu > ETH_DATA_LEN))
-		features &= ~NETIF_F_ALL_CSUM;
+		features &= ~NETIF_F_CSUM_MASK;
 
 	return features;
 }
@@ -1477,6 +3849,8 @@ static irqreturn_t stmmac_interrupt(int irq, void *dev_id)
 		return IRQ_NONE;
 	}
 
+	trace_stmmac_irq(dev);
+
 	if (priv->plat->has_gmac)
 		/* To handle GMAC own interrupts */
 		priv->hw->mac->host_irq_status((void __iomem *) dev->base_addr);
@@ -1518,44 +3892,95 @@ static int stmmac_ioctl(struct net_device *dev, struct ifreq *rq, int cmd)
 	if (!priv->phydev)
 		return -EINVAL;
 
-	spin_lock(&priv->lock);
+	/* The MDIO accesses sleep: phylib does its own locking */
 	ret = phy_mii_ioctl(priv->phydev, rq, cmd);
-	spin_unlock(&priv->lock);
 
 	return ret;
 }
 
-#ifdef STMMAC_VLAN_TAG_USED
-static void stmmac_vlan_rx_register(struct net_device *dev,
-				    struct vlan_group *grp)
+static const char * const stmmac_tx_completion_names[] = {
+	[TX_COMPLETION_IRQ] = "irq",
+	[TX_COMPLETION_POSTCHK] = "postchk",
+	[TX_COMPLETION_TIMER] = "timer",
+};
+
+static ssize_t tx_completion_show(struct device *d,
+				  struct device_attribute *attr, char *buf)
 {
-	struct stmmac_priv *priv = netdev_priv(dev);
+	struct stmmac_priv *priv = netdev_priv(to_net_dev(d));
 
-	DBG(probe, INFO, "%s: Setting vlgrp to %p\n", dev->name, grp);
+	return sprintf(buf, "%s\n",
+		stmmac_tx_completion_names[READ_ONCE(priv->tx_completion)]);
+}
 
-	spin_lock(&priv->lock);
-	priv->vlgrp = grp;
-	spin_unlock(&priv->lock);
+/**
+ * tx_completion_store - select the TX completion strategy
+ * Description: the strategy is switched with the TX NAPI disabled, so
+ * nobody can reclaim or touch the TX interrupt mask meanwhile. The NAPI is
+ * then kicked once for the frames completed during the switch.
+ */
+static ssize_t tx_completion_store(struct device *d,
+				   struct device_attribute *attr,
+				   const char *buf, size_t len)
+{
+	struct net_device *dev = to_net_dev(d);
+	struct stmmac_priv *priv = netdev_priv(dev);
+	int mode;
+
+	mode = sysfs_match_string(stmmac_tx_completion_names, buf);
+	if (mode < 0)
+		return mode;
+
+	if (!rtnl_trylock())
+		return restart_syscall();
+
+	/* Without its rings the TX NAPI is already off: stmmac_unquiesce
+	 * programs the mode */
+	if (netif_running(dev) && !stmmac_rings_lost(priv)) {
+		napi_disable(&priv->tx_napi);
+		WRITE_ONCE(priv->tx_completion, mode);
+		stmmac_tx_completion_irq(priv);
+		napi_enable(&priv->tx_napi);
+
+		local_bh_disable();
+		stmmac_schedule_tx(priv);
+		local_bh_enable();
+	} else
+		WRITE_ONCE(priv->tx_completion, mode);
+
+	rtnl_unlock();
+	return len;
 }
-#endif
+static DEVICE_ATTR_RW(tx_completion);
+
+static struct attribute *stmmac_attrs[] = {
+	&dev_attr_tx_completion.attr,
+	NULL,
+};
+
+static const struct attribute_group stmmac_attr_group = {
+	.attrs = stmmac_attrs,
+};
 
 static const struct net_device_ops stmmac_netdev_ops = {
 	.ndo_open = stmmac_open,
 	.ndo_start_xmit = stmmac_xmit,
 	.ndo_stop = stmmac_release,
+	.ndo_get_stats64 = stmmac_get_stats64,
 	.ndo_change_mtu = stmmac_change_mtu,
 	.ndo_fix_features = stmmac_fix_features,
-	.ndo_set_multicast_list = stmmac_multicast_list,
+	.ndo_features_check = stmmac_features_check,
+	.ndo_set_rx_mode = stmmac_multicast_list,
 	.ndo_tx_timeout = stmmac_tx_timeout,
-	.ndo_do_ioctl = stmmac_ioctl,
+	.ndo_eth_ioctl = stmmac_ioctl,
 	.ndo_set_config = stmmac_config,
-#ifdef STMMAC_VLAN_TAG_USED
-	.ndo_vlan_rx_register = stmmac_vlan_rx_register,
-#endif
 #ifdef CONFIG_NET_POLL_CONTROLLER
 	.ndo_poll_controller = stmmac_poll_controller,
 #endif
 	.ndo_set_mac_address = eth_mac_addr,
+	.ndo_bpf = stmmac_bpf,
+	.ndo_xdp_xmit = stmmac_xdp_xmit,
+	.ndo_xsk_wakeup = stmmac_xsk_wakeup,
 };
 
 /**
@@ -1569,6 +3994,8 @@ static int stmmac_probe(struct net_device *dev)
 {
 	int ret = 0;
 	struct stmmac_priv *priv = netdev_priv(dev);
+	u8 addr[ETH_ALEN];
+
 	if ((priv->platform_id == 0) || (priv->platform_id == -1))
 		priv->clk = clk_get(&dev->dev, MAC0_CLK_NAME);
 	else if (priv->platform_id == 1)
@@ -1580,7 +4007,7 @@ static int stmmac_probe(struct net_device *dev)
 		ret = PTR_ERR(priv->clk);
 		return ret;
 	}
-	clk_enable(priv->clk);
+	clk_prepare_enable(priv->clk);
 
 	ether_setup(dev);
 
@@ -1588,29 +4015,54 @@ static int stmmac_probe(struct net_device *dev)
 	stmmac_set_ethtool_ops(dev);
 
 	dev->hw_features = NETIF_F_SG | NETIF_F_IP_CSUM | NETIF_F_IPV6_CSUM;
+	/* Software TSO: the checksum engine completes each segment */
+	if (priv->plat->tx_coe)
+		dev->hw_features |= NETIF_F_TSO | NETIF_F_TSO6;
 	dev->features |= dev->hw_features | NETIF_F_HIGHDMA;
 	dev->watchdog_timeo = msecs_to_jiffies(watchdog);
-#ifdef STMMAC_VLAN_TAG_USED
-	/* Both mac100 and gmac support receive VLAN tag detection */
-	dev->features |= NETIF_F_HW_VLAN_RX;
-#endif
+	/* The MAC detects the VLAN tags but never strips them, so no VLAN
+	 * offload is advertised */
+	dev->min_mtu = 46;
+	dev->max_mtu = priv->plat->has_gmac ? JUMBO_LEN : ETH_DATA_LEN;
 	priv->msg_enable = netif_msg_init(debug, default_msg_level);
 
 	if (flow_ctrl)
 		priv->flow_ctrl = FLOW_AUTO;	/* RX/TX pause on */
 
 	priv->pause = pause;
-	netif_napi_add(dev, &priv->napi, stmmac_poll, GMAC_NAPI_WEIGHT);
+	priv->priv_flags = STMMAC_PRIV_FLAG_RX_PARTIAL_SYNC;
+	priv->rx_copybreak = STMMAC_RX_COPYBREAK;
+	priv->tx_copybreak = STMMAC_TX_COPYBREAK;
+	priv->tx_coal_frames = STMMAC_TX_FRAMES;
+	priv->tx_coal_timer = STMMAC_COAL_TX_TIMER;
+	priv->rx_coal_frames = STMMAC_RX_FRAMES;
+	priv->tx_completion = TX_COMPLETION_DEFAULT;
+#ifdef CONFIG_STMMAC_TIMER
+	/* The parameter can have been changed since the module was loaded */
+	stmmac_verify_args();
+	priv->tmrate = tmrate;
+#endif
+	INIT_WORK(&priv->tx_err_work, stmmac_tx_err_work);
+	netif_napi_add_weight(dev, &priv->napi, stmmac_poll, GMAC_NAPI_WEIGHT);
+	netif_napi_add_tx_weight(dev, &priv->tx_napi, stmmac_tx_poll,
+				 GMAC_TX_NAPI_WEIGHT);
 
 	/* Get the MAC address */
-	priv->hw->mac->get_umac_addr((void __iomem *) dev->base_addr,
-				     dev->dev_addr, 0);
+	priv->hw->mac->get_umac_addr((void __iomem *) dev->base_addr, addr, 0);
+	eth_hw_addr_set(dev, addr);
 
 	if (!is_valid_ether_addr(dev->dev_addr))
-		pr_warning("\tno valid MAC address;"
+		pr_warn("\tno valid MAC address;"
 			"please, use ifconfig or nwhwconfig!\n");
 
 	spin_lock_init(&priv->lock);
+	spin_lock_init(&priv->irq_lock);
+	spin_lock_init(&priv->mmc_lock);
+	u64_stats_init(&priv->rx_stats.syncp);
+	u64_stats_init(&priv->tx_stats.syncp);
+	u64_stats_init(&priv->txc_stats.syncp);
+
+	dev->sysfs_groups[0] = &stmmac_attr_group;
 
 	ret = register_netdev(dev);
 	if (ret) {
@@ -1873,6 +4325,9 @@ static int stmmac_dvr_probe(struct platform_device *pdev)
 	if (ret < 0)
 		goto out_unregister;
 	pr_debug("registered!\n");
+#ifdef CONFIG_SILAN_GMAC_FWD
+	stmmac_fwd_register(priv);
+#endif
 	return 0;
 
 out_unregister:
@@ -1906,6 +4361,10 @@ static int stmmac_dvr_remove(struct platform_device *pdev)
 
 	pr_info("%s:\n\tremoving driver", __func__);
 
+#ifdef CONFIG_SILAN_GMAC_FWD
+	stmmac_fwd_unregister(priv);
+#endif
+
 	priv->hw->dma->stop_rx(priv->ioaddr);
 	priv->hw->dma->stop_tx(priv->ioaddr);
 
@@ -1937,30 +4396,40 @@ static int stmmac_suspend(struct device *dev)
 	struct stmmac_priv *priv = netdev_priv(ndev);
 	int dis_ic = 0;
 
-	if (!ndev || !netif_running(ndev))
+	if (!ndev || !netif_running(ndev) || stmmac_rings_lost(priv))
 		return 0;
 
-	spin_lock(&priv->lock);
-
+	stmmac_mmc_stop(priv);
 	netif_device_detach(ndev);
+	stmmac_tx_err_sync(priv);
+
+	/* phylib and the NAPI disable sleep: not under the spinlock */
 	netif_stop_queue(ndev);
 	if (priv->phydev)
 		phy_stop(priv->phydev);
+	napi_disable(&priv->napi);
+	napi_disable(&priv->tx_napi);
+
+	spin_lock(&priv->lock);
 
 #ifdef CONFIG_STMMAC_TIMER
-	priv->tm->timer_stop();
+	priv->tm->timer_stop(priv->tm);
 	if (likely(priv->tm->enable))
 		dis_ic = 1;
 #endif
-	napi_disable(&priv->napi);
 
 	/* Stop TX/RX DMA */
 	priv->hw->dma->stop_tx(priv->ioaddr);
 	priv->hw->dma->stop_rx(priv->ioaddr);
 	/* Clear the Rx/Tx descriptors */
 	priv->hw->desc->init_rx_desc(priv->dma_rx, priv->dma_rx_size,
-				     dis_ic);
+				     dis_ic, priv->dma_buf_sz);
 	priv->hw->desc->init_tx_desc(priv->dma_tx, priv->dma_tx_size);
+	if (stmmac_rx_desc_cached(priv))
+		dma_sync_single_for_device(priv->device, priv->dma_rx_phy,
+					   priv->dma_rx_size *
+					   sizeof(struct dma_desc),
+					   DMA_BIDIRECTIONAL);
 
 	/* Enable Power down mode by programming the PMT regs */
 	if (device_may_wakeup(priv->device))
@@ -1969,7 +4438,7 @@ static int stmmac_suspend(struct device *dev)
 		stmmac_disable_mac(priv->ioaddr);
 
 	spin_unlock(&priv->lock);
-	clk_disable(priv->clk);
+	clk_disable_unprepare(priv->clk);
 	return 0;
 }
 
@@ -1978,10 +4447,12 @@ static int stmmac_resume(struct device *dev)
 	struct net_device *ndev = dev_get_drvdata(dev);
 	struct stmmac_priv *priv = netdev_priv(ndev);
 
-	if (!netif_running(ndev))
+	if (!netif_running(ndev) || stmmac_rings_lost(priv))
 		return 0;
 
-	clk_enable(priv->clk);
+	clk_prepare_enable(priv->clk);
+	napi_enable(&priv->napi);
+	napi_enable(&priv->tx_napi);
 	spin_lock(&priv->lock);
 
 	/* Power Down bit, into the PM register, is cleared
@@ -1996,21 +4467,22 @@ static int stmmac_resume(struct device *dev)
 
 	/* Enable the MAC and DMA */
 	stmmac_enable_mac(priv->ioaddr);
+	priv->rx_coal_update = false;
+	stmmac_rx_coalesce_write(priv);
 	priv->hw->dma->start_tx(priv->ioaddr);
 	priv->hw->dma->start_rx(priv->ioaddr);
 
 #ifdef CONFIG_STMMAC_TIMER
 	if (likely(priv->tm->enable))
-		priv->tm->timer_start(tmrate);
+		priv->tm->timer_start(priv->tm, priv->tm->freq);
 #endif
-	napi_enable(&priv->napi);
+	spin_unlock(&priv->lock);
 
 	if (priv->phydev)
 		phy_start(priv->phydev);
 
 	netif_start_queue(ndev);
-
-	spin_unlock(&priv->lock);
+	stmmac_mmc_start(priv);
 	return 0;
 }
 
@@ -2074,46 +4546,65 @@ static struct platform_driver stmmac1_driver = {
  */
 static int __init stmmac_init_module(void)
 {
+	stmmac_hist_debugfs_init();
 #ifdef CONFIG_SILAN_ETH0
 	if (platform_driver_register(&stmmacphy_driver)) {
 		pr_err("No PHY devices registered!\n");
-		return -ENODEV;
+		goto err_debugfs;
 	}
 
 	if (platform_driver_register(&stmmac_driver)) {
 		pr_err("No MAC devices registered!\n");
-		return -ENODEV;
-	};
+		goto err_phy0;
+	}
 #endif
 #ifdef CONFIG_SILAN_ETH1
 	if (platform_driver_register(&stmmac1phy_driver)) {
 		pr_err("No PHY devices registered!\n");
-		return -ENODEV;
+		goto err_mac0;
 	}
 
 	if (platform_driver_register(&stmmac1_driver)) {
 		pr_err("No MAC devices registered!\n");
-		return -ENODEV;
-	};
+		goto err_phy1;
+	}
 #endif
 
 	return 0;
+
+#ifdef CONFIG_SILAN_ETH1
+err_phy1:
+	platform_driver_unregister(&stmmac1phy_driver);
+err_mac0:
+#endif
+#ifdef CONFIG_SILAN_ETH0
+	platform_driver_unregister(&stmmac_driver);
+err_phy0:
+	platform_driver_unregister(&stmmacphy_driver);
+#endif
+#if defined(CONFIG_SILAN_ETH0) || defined(CONFIG_SILAN_ETH1)
+err_debugfs:
+	stmmac_hist_debugfs_exit();
+	return -ENODEV;
+#endif
 }
 
 /**
  * stmmac_cleanup_module - Cleanup routine for the driver
- * Description: This function is the cleanup routine for the driver.
+ * Description: This function is the cleanup routine for the driver. The
+ * debugfs root goes last, once the devices have removed their directories.
  */
 static void __exit stmmac_cleanup_module(void)
 {
-#ifdef CONFIG_SILAN_ETH0
-	platform_driver_unregister(&stmmacphy_driver);
-	platform_driver_unregister(&stmmac_driver);
-#endif
 #ifdef CONFIG_SILAN_ETH1
-	platform_driver_unregister(&stmmac1phy_driver);
 	platform_driver_unregister(&stmmac1_driver);
+	platform_driver_unregister(&stmmac1phy_driver);
+#endif
+#ifdef CONFIG_SILAN_ETH0
+	platform_driver_unregister(&stmmac_driver);
+	platform_driver_unregister(&stmmacphy_driver);
 #endif
+	stmmac_hist_debugfs_exit();
 }
 
 #ifndef MODULE
@@ -0,0 +1,177 @@
+/*******************************************************************************
+  Silan GMAC: MMC (RMON) counters
+
+  Copyright (C) 2013 Silan Microelectronics Ltd
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms and conditions of the GNU General Public License,
+  version 2, as published by the Free Software Foundation.
+
+  This program is distributed in the hope it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU General Public License along with
+  this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+
+  The full GNU General Public License is included in this distribution in
+  the file called "COPYING".
+
+  The GMAC counts frames, octets and errors in its MMC module, next to the
+  missed frame counter of the DMA (CSR8). All of them are cleared on read
+  and folded into 64 bit totals by a timer, so they never wrap and the
+  datapath does not pay for them. The same timer turns the bytes saved by
+  the partial RX sync into a rate.
+*******************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/io.h>
+#include <linux/netdevice.h>
+#include "stmmac.h"
+#include "dwmac1000.h"
+
+#define STMMAC_MMC_CNT(reg, m)	\
+	{ reg, offsetof(struct stmmac_counters, m) }
+
+static const struct {
+	u16 reg;
+	u16 offset;
+} stmmac_mmc_regs[] = {
+	STMMAC_MMC_CNT(MMC_TX_OCTETCOUNT_GB, mmc_tx_octetcount_gb),
+	STMMAC_MMC_CNT(MMC_TX_FRAMECOUNT_GB, mmc_tx_framecount_gb),
+	STMMAC_MMC_CNT(MMC_TX_OCTETCOUNT_G, mmc_tx_octetcount_g),
+	STMMAC_MMC_CNT(MMC_TX_FRAMECOUNT_G, mmc_tx_framecount_g),
+	STMMAC_MMC_CNT(MMC_TX_UNDERFLOW_ERROR, mmc_tx_underflow_error),
+	STMMAC_MMC_CNT(MMC_TX_LATECOL, mmc_tx_latecol),
+	STMMAC_MMC_CNT(MMC_TX_EXESSCOL, mmc_tx_exesscol),
+	STMMAC_MMC_CNT(MMC_TX_CARRIER_ERROR, mmc_tx_carrier_error),
+	STMMAC_MMC_CNT(MMC_TX_PAUSE_FRAME, mmc_tx_pause_frame),
+	STMMAC_MMC_CNT(MMC_RX_FRAMECOUNT_GB, mmc_rx_framecount_gb),
+	STMMAC_MMC_CNT(MMC_RX_OCTETCOUNT_GB, mmc_rx_octetcount_gb),
+	STMMAC_MMC_CNT(MMC_RX_OCTETCOUNT_G, mmc_rx_octetcount_g),
+	STMMAC_MMC_CNT(MMC_RX_UNICAST_G, mmc_rx_unicast_g),
+	STMMAC_MMC_CNT(MMC_RX_MULTICASTFRAME_G, mmc_rx_multicastframe_g),
+	STMMAC_MMC_CNT(MMC_RX_BROADCASTFRAME_G, mmc_rx_broadcastframe_g),
+	STMMAC_MMC_CNT(MMC_RX_CRC_ERROR, mmc_rx_crc_error),
+	STMMAC_MMC_CNT(MMC_RX_ALIGN_ERROR, mmc_rx_align_error),
+	STMMAC_MMC_CNT(MMC_RX_RUN_ERROR, mmc_rx_run_error),
+	STMMAC_MMC_CNT(MMC_RX_JABBER_ERROR, mmc_rx_jabber_error),
+	STMMAC_MMC_CNT(MMC_RX_OVERSIZE_G, mmc_rx_oversize_g),
+	STMMAC_MMC_CNT(MMC_RX_LENGTH_ERROR, mmc_rx_length_error),
+	STMMAC_MMC_CNT(MMC_RX_PAUSE_FRAMES, mmc_rx_pause_frames),
+	STMMAC_MMC_CNT(MMC_RX_FIFO_OVERFLOW, mmc_rx_fifo_overflow),
+	STMMAC_MMC_CNT(MMC_RX_WATCHDOG_ERROR, mmc_rx_watchdog_error),
+};
+
+/* Called with mmc_lock held */
+static void stmmac_mmc_collect(struct stmmac_priv *priv)
+{
+	void __iomem *ioaddr = priv->ioaddr;
+	int i;
+
+	priv->hw->dma->dma_diagnostic_fr(&priv->dev->stats, &priv->xstats,
+					 ioaddr);
+	if (!priv->plat->has_gmac)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(stmmac_mmc_regs); i++) {
+		u64 *cnt = (u64 *)((char *)&priv->mmc +
+				   stmmac_mmc_regs[i].offset);
+
+		*cnt += readl(ioaddr + stmmac_mmc_regs[i].reg);
+	}
+}
+
+/* Bytes per second the partial RX sync saved over the last period. Only
+ * the timer writes the rate state, the readers just load the result. */
+static void stmmac_rx_sync_rate(struct stmmac_priv *priv)
+{
+	unsigned long now = jiffies;
+	unsigned int start;
+	u64 saved;
+
+	if (!time_after(now, priv->rx_sync_stamp))
+		return;
+
+	do {
+		start = u64_stats_fetch_begin(&priv->rx_stats.syncp);
+		saved = u64_stats_read(&priv->rx_stats.sync_saved_bytes);
+	} while (u64_stats_fetch_retry(&priv->rx_stats.syncp, start));
+
+	WRITE_ONCE(priv->xstats.rx_sync_saved_bps,
+		   div_u64((saved - priv->rx_sync_saved_last) * HZ,
+			   now - priv->rx_sync_stamp));
+	priv->rx_sync_saved_last = saved;
+	priv->rx_sync_stamp = now;
+}
+
+static void stmmac_mmc_timer(struct timer_list *t)
+{
+	struct stmmac_priv *priv = from_timer(priv, t, mmc_timer);
+
+	stmmac_rx_sync_rate(priv);
+
+	spin_lock_bh(&priv->mmc_lock);
+	stmmac_mmc_collect(priv);
+	spin_unlock_bh(&priv->mmc_lock);
+
+	mod_timer(&priv->mmc_timer, jiffies + STMMAC_MMC_PERIOD);
+}
+
+/**
+ * stmmac_mmc_init - set up the MMC module and start the collector
+ * @priv: private driver structure
+ * Description: called at the end of the open; the MAC core initialisation
+ * has frozen the counters. The MMC interrupts stay masked: nothing waits
+ * for a counter to reach half of its range.
+ */
+void stmmac_mmc_init(struct stmmac_priv *priv)
+{
+	if (priv->plat->has_gmac) {
+		writel(0xffffffff, priv->ioaddr + MMC_RX_IPC_INTR_MASK);
+		writel(MMC_CNTRL_RESET_ON_READ | MMC_CNTRL_COUNTER_RESET,
+		       priv->ioaddr + GMAC_MMC_CTRL);
+	}
+
+	timer_setup(&priv->mmc_timer, stmmac_mmc_timer, 0);
+	stmmac_mmc_start(priv);
+}
+
+void stmmac_mmc_start(struct stmmac_priv *priv)
+{
+	mod_timer(&priv->mmc_timer, jiffies + STMMAC_MMC_PERIOD);
+}
+
+/**
+ * stmmac_mmc_stop - stop the collector
+ * @priv: private driver structure
+ * Description: the counters are folded one last time, before the clock of
+ * the controller can be turned off.
+ */
+void stmmac_mmc_stop(struct stmmac_priv *priv)
+{
+	del_timer_sync(&priv->mmc_timer);
+
+	spin_lock_bh(&priv->mmc_lock);
+	stmmac_mmc_collect(priv);
+	spin_unlock_bh(&priv->mmc_lock);
+}
+
+/**
+ * stmmac_mmc_read - up to date copy of the totals
+ * @priv: private driver structure
+ * @mmc: where to copy them
+ * Description: the hardware counters are folded first when the interface
+ * is running; dev->stats and the extra statistics get the DMA missed frame
+ * counters at the same time.
+ */
+void stmmac_mmc_read(struct stmmac_priv *priv, struct stmmac_counters *mmc)
+{
+	spin_lock_bh(&priv->mmc_lock);
+	if (netif_running(priv->dev) && netif_device_present(priv->dev))
+		stmmac_mmc_collect(priv);
+	*mmc = priv->mmc;
+	spin_unlock_bh(&priv->mmc_lock);
+}
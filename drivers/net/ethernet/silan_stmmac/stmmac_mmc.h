@@ -0,0 +1,100 @@
+/*******************************************************************************
+  Silan GMAC: MMC (RMON) counters
+
+  Copyright (C) 2013 Silan Microelectronics Ltd
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms and conditions of the GNU General Public License,
+  version 2, as published by the Free Software Foundation.
+
+  This program is distributed in the hope it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU General Public License along with
+  this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+
+  The full GNU General Public License is included in this distribution in
+  the file called "COPYING".
+*******************************************************************************/
+#ifndef __STMMAC_MMC_H__
+#define __STMMAC_MMC_H__
+
+/* MMC control register */
+#define MMC_CNTRL_COUNTER_RESET		0x1	/* Reset all the counters */
+#define MMC_CNTRL_COUNTER_STOP_ROLLOVER	0x2	/* Saturate at the maximum */
+#define MMC_CNTRL_RESET_ON_READ		0x4	/* Cleared when read */
+#define MMC_CNTRL_COUNTER_FREEZER	0x8	/* Freeze the counters */
+
+#define MMC_RX_IPC_INTR_MASK		0x00000200
+
+/* GMAC MMC counters */
+#define MMC_TX_OCTETCOUNT_GB		0x00000114
+#define MMC_TX_FRAMECOUNT_GB		0x00000118
+#define MMC_TX_UNDERFLOW_ERROR		0x00000148
+#define MMC_TX_LATECOL			0x00000158
+#define MMC_TX_EXESSCOL			0x0000015c
+#define MMC_TX_CARRIER_ERROR		0x00000160
+#define MMC_TX_OCTETCOUNT_G		0x00000164
+#define MMC_TX_FRAMECOUNT_G		0x00000168
+#define MMC_TX_PAUSE_FRAME		0x00000170
+
+#define MMC_RX_FRAMECOUNT_GB		0x00000180
+#define MMC_RX_OCTETCOUNT_GB		0x00000184
+#define MMC_RX_OCTETCOUNT_G		0x00000188
+#define MMC_RX_BROADCASTFRAME_G		0x0000018c
+#define MMC_RX_MULTICASTFRAME_G		0x00000190
+#define MMC_RX_CRC_ERROR		0x00000194
+#define MMC_RX_ALIGN_ERROR		0x00000198
+#define MMC_RX_RUN_ERROR		0x0000019c
+#define MMC_RX_JABBER_ERROR		0x000001a0
+#define MMC_RX_OVERSIZE_G		0x000001a8
+#define MMC_RX_UNICAST_G		0x000001c4
+#define MMC_RX_LENGTH_ERROR		0x000001c8
+#define MMC_RX_PAUSE_FRAMES		0x000001d0
+#define MMC_RX_FIFO_OVERFLOW		0x000001d4
+#define MMC_RX_WATCHDOG_ERROR		0x000001dc
+
+/* The hardware counters are 32 bit wide: they are folded into these
+ * totals well before the octet counters can wrap (34 s at 1 Gb/s) */
+#define STMMAC_MMC_PERIOD	(10 * HZ)
+
+struct stmmac_counters {
+	u64 mmc_tx_octetcount_gb;
+	u64 mmc_tx_framecount_gb;
+	u64 mmc_tx_octetcount_g;
+	u64 mmc_tx_framecount_g;
+	u64 mmc_tx_underflow_error;
+	u64 mmc_tx_latecol;
+	u64 mmc_tx_exesscol;
+	u64 mmc_tx_carrier_error;
+	u64 mmc_tx_pause_frame;
+
+	u64 mmc_rx_framecount_gb;
+	u64 mmc_rx_octetcount_gb;
+	u64 mmc_rx_octetcount_g;
+	u64 mmc_rx_unicast_g;
+	u64 mmc_rx_multicastframe_g;
+	u64 mmc_rx_broadcastframe_g;
+	u64 mmc_rx_crc_error;
+	u64 mmc_rx_align_error;
+	u64 mmc_rx_run_error;
+	u64 mmc_rx_jabber_error;
+	u64 mmc_rx_oversize_g;
+	u64 mmc_rx_length_error;
+	u64 mmc_rx_pause_frames;
+	u64 mmc_rx_fifo_overflow;
+	u64 mmc_rx_watchdog_error;
+};
+
+struct stmmac_priv;
+
+extern void stmmac_mmc_init(struct stmmac_priv *priv);
+extern void stmmac_mmc_start(struct stmmac_priv *priv);
+extern void stmmac_mmc_stop(struct stmmac_priv *priv);
+extern void stmmac_mmc_read(struct stmmac_priv *priv,
+			    struct stmmac_counters *mmc);
+
+#endif /* __STMMAC_MMC_H__ */
@@ -41,13 +41,13 @@ printk(KERN_INFO "stmmac_timer: %s Timer ON (freq %dHz)\n", timer, freq);
 static struct rtc_device *stmmac_rtc;
 static rtc_task_t stmmac_task;
 
-static void stmmac_rtc_start(unsigned int new_freq)
+static void stmmac_rtc_start(struct stmmac_timer *tm, unsigned int new_freq)
 {
 	rtc_irq_set_freq(stmmac_rtc, &stmmac_task, new_freq);
 	rtc_irq_set_state(stmmac_rtc, &stmmac_task, 1);
 }
 
-static void stmmac_rtc_stop(void)
+static void stmmac_rtc_stop(struct stmmac_timer *tm)
 {
 	rtc_irq_set_state(stmmac_rtc, &stmmac_task, 0);
 }
@@ -81,7 +81,7 @@ int stmmac_open_ext_timer(struct net_device *dev, struct stmmac_timer *tm)
 	return 0;
 }
 
-int stmmac_close_ext_timer(void)
+int stmmac_close_ext_timer(struct stmmac_timer *tm)
 {
 	rtc_irq_set_state(stmmac_rtc, &stmmac_task, 0);
 	rtc_irq_unregister(stmmac_rtc, &stmmac_task);
@@ -94,13 +94,13 @@ int stmmac_close_ext_timer(void)
 #define TMU_CHANNEL "tmu2_clk"
 static struct clk *timer_clock;
 
-static void stmmac_tmu_start(unsigned int new_freq)
+static void stmmac_tmu_start(struct stmmac_timer *tm, unsigned int new_freq)
 {
 	clk_set_rate(timer_clock, new_freq);
 	clk_enable(timer_clock);
 }
 
-static void stmmac_tmu_stop(void)
+static void stmmac_tmu_stop(struct stmmac_timer *tm)
 {
 	clk_disable(timer_clock);
 }
@@ -124,11 +124,70 @@ int stmmac_open_ext_timer(struct net_device *dev, struct stmmac_timer *tm)
 	return 0;
 }
 
-int stmmac_close_ext_timer(void)
+int stmmac_close_ext_timer(struct stmmac_timer *tm)
 {
 	clk_disable(timer_clock);
 	tmu2_unregister_user();
 	clk_put(timer_clock);
 	return 0;
 }
+
+#elif defined(CONFIG_STMMAC_HRTIMER)
+/* Each interface has its own hrtimer embedded in the stmmac_timer.
+ * The timer is stopped from its own handler (through stmmac_schedule)
+ * as soon as some work is found, so the stop path cannot wait for it:
+ * the "running" flag tells the handler not to rearm itself. */
+static enum hrtimer_restart stmmac_hrtimer_handler(struct hrtimer *t)
+{
+	struct stmmac_timer *tm = container_of(t, struct stmmac_timer, hrtimer);
+	unsigned int freq;
+
+	stmmac_schedule(tm->dev);
+
+	if (!READ_ONCE(tm->running))
+		return HRTIMER_NORESTART;
+
+	/* ethtool -C can change the rate while the timer runs */
+	freq = READ_ONCE(tm->freq);
+	hrtimer_forward_now(t, ns_to_ktime(NSEC_PER_SEC / freq));
+	return HRTIMER_RESTART;
+}
+
+static void stmmac_hrtimer_start(struct stmmac_timer *tm,
+				 unsigned int new_freq)
+{
+	WRITE_ONCE(tm->freq, new_freq);
+	WRITE_ONCE(tm->running, 1);
+	hrtimer_start(&tm->hrtimer, ns_to_ktime(NSEC_PER_SEC / new_freq),
+		      HRTIMER_MODE_REL);
+}
+
+static void stmmac_hrtimer_stop(struct stmmac_timer *tm)
+{
+	WRITE_ONCE(tm->running, 0);
+	hrtimer_try_to_cancel(&tm->hrtimer);
+}
+
+int stmmac_open_ext_timer(struct net_device *dev, struct stmmac_timer *tm)
+{
+	if (!tm->freq)
+		return -EINVAL;
+
+	tm->dev = dev;
+	hrtimer_init(&tm->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	tm->hrtimer.function = stmmac_hrtimer_handler;
+
+	STMMAC_TIMER_MSG("hrtimer", tm->freq);
+	tm->timer_start = stmmac_hrtimer_start;
+	tm->timer_stop = stmmac_hrtimer_stop;
+
+	return 0;
+}
+
+int stmmac_close_ext_timer(struct stmmac_timer *tm)
+{
+	WRITE_ONCE(tm->running, 0);
+	hrtimer_cancel(&tm->hrtimer);
+	return 0;
+}
 #endif
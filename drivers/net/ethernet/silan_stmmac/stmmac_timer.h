@@ -25,17 +25,24 @@
 #ifndef STMMAC_TIMER_H
 #define STMMAC_TIMER_H
 
+#include <linux/hrtimer.h>
+
 struct stmmac_timer {
-	void (*timer_start) (unsigned int new_freq);
-	void (*timer_stop) (void);
+	void (*timer_start) (struct stmmac_timer *tm, unsigned int new_freq);
+	void (*timer_stop) (struct stmmac_timer *tm);
 	unsigned int freq;
 	unsigned int enable;
+#ifdef CONFIG_STMMAC_HRTIMER
+	struct hrtimer hrtimer;
+	struct net_device *dev;
+	unsigned int running;
+#endif
 };
 
 /* Open the HW timer device and return 0 in case of success */
 int stmmac_open_ext_timer(struct net_device *dev, struct stmmac_timer *tm);
 /* Stop the timer and release it */
-int stmmac_close_ext_timer(void);
+int stmmac_close_ext_timer(struct stmmac_timer *tm);
 /* Function used for scheduling task within the stmmac */
 void stmmac_schedule(struct net_device *dev);
 
@@ -0,0 +1,261 @@
+/*******************************************************************************
+  Silan GMAC: tracepoints of the datapath
+
+  Copyright (C) 2013 Silan Microelectronics Ltd
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms and conditions of the GNU General Public License,
+  version 2, as published by the Free Software Foundation.
+
+  This program is distributed in the hope it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU General Public License along with
+  this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+
+  The full GNU General Public License is included in this distribution in
+  the file called "COPYING".
+
+  Unlike the TX_DBG/RX_DBG/DWMAC_LIB_DBG printk they cost a patched out
+  branch when disabled, so they stay built in. They can be enabled on a
+  live box from /sys/kernel/tracing/events/stmmac or with
+  "perf record -e 'stmmac:*'".
+*******************************************************************************/
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM stmmac
+
+#if !defined(__STMMAC_TRACE_H__) || defined(TRACE_HEADER_MULTI_READ)
+#define __STMMAC_TRACE_H__
+
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+#include <linux/tracepoint.h>
+#include "descs.h"
+
+/* Entry of the IRQ handler, before CSR5 is read */
+TRACE_EVENT(stmmac_irq,
+	TP_PROTO(const struct net_device *dev),
+
+	TP_ARGS(dev),
+
+	TP_STRUCT__entry(
+		__string(name, dev->name)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev->name);
+	),
+
+	TP_printk("dev=%s", __get_str(name))
+);
+
+/* The raw DMA status (CSR5) and interrupt enable (CSR7) registers; the
+ * DMA library only knows the base address of the controller */
+TRACE_EVENT(stmmac_dma_irq,
+	TP_PROTO(const void __iomem *ioaddr, u32 csr5, u32 csr7),
+
+	TP_ARGS(ioaddr, csr5, csr7),
+
+	TP_STRUCT__entry(
+		__field(unsigned long, ioaddr)
+		__field(u32, csr5)
+		__field(u32, csr7)
+	),
+
+	TP_fast_assign(
+		__entry->ioaddr = (unsigned long)ioaddr;
+		__entry->csr5 = csr5;
+		__entry->csr7 = csr7;
+	),
+
+	TP_printk("ioaddr=0x%lx csr5=0x%08x csr7=0x%08x",
+		  __entry->ioaddr, __entry->csr5, __entry->csr7)
+);
+
+/* A frame queued on the TX ring: first entry and number of descriptors.
+ * kick is the BQL verdict; a queue stopped right after rings as well. */
+TRACE_EVENT(stmmac_xmit,
+	TP_PROTO(const struct net_device *dev, const struct sk_buff *skb,
+		 unsigned int entry, unsigned int ndesc, bool kick),
+
+	TP_ARGS(dev, skb, entry, ndesc, kick),
+
+	TP_STRUCT__entry(
+		__string(name, dev->name)
+		__field(const void *, skbaddr)
+		__field(unsigned int, len)
+		__field(unsigned int, entry)
+		__field(unsigned int, ndesc)
+		__field(bool, kick)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev->name);
+		__entry->skbaddr = skb;
+		__entry->len = skb->len;
+		__entry->entry = entry;
+		__entry->ndesc = ndesc;
+		__entry->kick = kick;
+	),
+
+	TP_printk("dev=%s skbaddr=%p len=%u entry=%u ndesc=%u kick=%d",
+		  __get_str(name), __entry->skbaddr, __entry->len,
+		  __entry->entry, __entry->ndesc, __entry->kick)
+);
+
+/* One TX reclaim batch; pending is what is still left on the ring */
+TRACE_EVENT(stmmac_tx_clean,
+	TP_PROTO(const struct net_device *dev, int count, unsigned int pkts,
+		 unsigned int bytes, unsigned int pending),
+
+	TP_ARGS(dev, count, pkts, bytes, pending),
+
+	TP_STRUCT__entry(
+		__string(name, dev->name)
+		__field(int, count)
+		__field(unsigned int, pkts)
+		__field(unsigned int, bytes)
+		__field(unsigned int, pending)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev->name);
+		__entry->count = count;
+		__entry->pkts = pkts;
+		__entry->bytes = bytes;
+		__entry->pending = pending;
+	),
+
+	TP_printk("dev=%s count=%d pkts=%u bytes=%u pending=%u",
+		  __get_str(name), __entry->count, __entry->pkts,
+		  __entry->bytes, __entry->pending)
+);
+
+/* Every RX descriptor closed by the DMA, with its raw RDES0 */
+TRACE_EVENT(stmmac_rx_frame,
+	TP_PROTO(const struct net_device *dev, unsigned int entry, u32 rdes0),
+
+	TP_ARGS(dev, entry, rdes0),
+
+	TP_STRUCT__entry(
+		__string(name, dev->name)
+		__field(unsigned int, entry)
+		__field(u32, rdes0)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev->name);
+		__entry->entry = entry;
+		__entry->rdes0 = rdes0;
+	),
+
+	TP_printk("dev=%s entry=%u rdes0=0x%08x len=%u",
+		  __get_str(name), __entry->entry, __entry->rdes0,
+		  (__entry->rdes0 >> RDES0_FRAME_LEN_SHIFT) &
+		  RDES0_FRAME_LEN_MASK)
+);
+
+/* End of an RX poll: descriptors processed against the budget */
+TRACE_EVENT(stmmac_rx_poll,
+	TP_PROTO(const struct net_device *dev, int count, int limit,
+		 unsigned int pkts, unsigned int bytes),
+
+	TP_ARGS(dev, count, limit, pkts, bytes),
+
+	TP_STRUCT__entry(
+		__string(name, dev->name)
+		__field(int, count)
+		__field(int, limit)
+		__field(unsigned int, pkts)
+		__field(unsigned int, bytes)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev->name);
+		__entry->count = count;
+		__entry->limit = limit;
+		__entry->pkts = pkts;
+		__entry->bytes = bytes;
+	),
+
+	TP_printk("dev=%s count=%d limit=%d pkts=%u bytes=%u",
+		  __get_str(name), __entry->count, __entry->limit,
+		  __entry->pkts, __entry->bytes)
+);
+
+/* Descriptors handed back to the DMA; missing is the refill shortfall */
+TRACE_EVENT(stmmac_rx_refill,
+	TP_PROTO(const struct net_device *dev, unsigned int refilled,
+		 unsigned int missing),
+
+	TP_ARGS(dev, refilled, missing),
+
+	TP_STRUCT__entry(
+		__string(name, dev->name)
+		__field(unsigned int, refilled)
+		__field(unsigned int, missing)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev->name);
+		__entry->refilled = refilled;
+		__entry->missing = missing;
+	),
+
+	TP_printk("dev=%s refilled=%u missing=%u",
+		  __get_str(name), __entry->refilled, __entry->missing)
+);
+
+/* The TX ring is reset after a fatal TX error */
+TRACE_EVENT(stmmac_tx_err,
+	TP_PROTO(const struct net_device *dev, unsigned int cur,
+		 unsigned int dirty),
+
+	TP_ARGS(dev, cur, dirty),
+
+	TP_STRUCT__entry(
+		__string(name, dev->name)
+		__field(unsigned int, cur)
+		__field(unsigned int, dirty)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev->name);
+		__entry->cur = cur;
+		__entry->dirty = dirty;
+	),
+
+	TP_printk("dev=%s cur=%u dirty=%u",
+		  __get_str(name), __entry->cur, __entry->dirty)
+);
+
+/* The DMA threshold raised after a transmit underflow */
+TRACE_EVENT(stmmac_tc_bump,
+	TP_PROTO(const struct net_device *dev, int tc),
+
+	TP_ARGS(dev, tc),
+
+	TP_STRUCT__entry(
+		__string(name, dev->name)
+		__field(int, tc)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev->name);
+		__entry->tc = tc;
+	),
+
+	TP_printk("dev=%s tc=%d", __get_str(name), __entry->tc)
+);
+
+#endif /* __STMMAC_TRACE_H__ */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE stmmac_trace
+#include <trace/define_trace.h>